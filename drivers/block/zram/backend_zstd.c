@@ -1,17 +1,31 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <linux/kernel.h>
+#include <linux/mutex.h>
 #include <linux/slab.h>
+#include <linux/unaligned.h>
 #include <linux/vmalloc.h>
 #include <linux/zstd.h>
 
 #include "backend_zstd.h"
 
+#define ZSTD_MAX_LIVE_DICTS	8
+
 struct zstd_ctx {
 	zstd_cctx *cctx;
 	zstd_dctx *dctx;
 	void *cctx_mem;
 	void *dctx_mem;
+	/* allocated on first use of a live dictionary, see zstd_live_cctx() */
+	zstd_cctx *live_cctx;
+};
+
+/* Dictionary loaded into a running device with zstd_add_dict() */
+struct zstd_live_dict {
+	void *dict;
+	u32 id;
+	zstd_cdict *cdict;
+	zstd_ddict *ddict;
 };
 
 struct zstd_params {
@@ -19,6 +33,15 @@ struct zstd_params {
 	zstd_cdict *cdict;
 	zstd_ddict *ddict;
 	zstd_parameters cprm;
+
+	/*
+	 * Live dictionaries are only appended and are kept until the comp
+	 * is released, so that every frame can still find its dictionary.
+	 * The newest one is used for compression.
+	 */
+	struct mutex live_lock;
+	unsigned int nr_live;
+	struct zstd_live_dict live[ZSTD_MAX_LIVE_DICTS];
 };
 
 /*
@@ -38,11 +61,18 @@ static void zstd_custom_free(void *opaque, void *address)
 static void zstd_release_params(struct zcomp_params *params)
 {
 	struct zstd_params *zp = params->drv_data;
+	unsigned int i;
 
 	params->drv_data = NULL;
 	if (!zp)
 		return;
 
+	for (i = 0; i < zp->nr_live; i++) {
+		zstd_free_cdict(zp->live[i].cdict);
+		zstd_free_ddict(zp->live[i].ddict);
+		vfree(zp->live[i].dict);
+	}
+
 	zstd_free_cdict(zp->cdict);
 	zstd_free_ddict(zp->ddict);
 	kfree(zp);
@@ -58,6 +88,7 @@ static int zstd_setup_params(struct zcomp_params *params)
 		return -ENOMEM;
 
 	params->drv_data = zp;
+	mutex_init(&zp->live_lock);
 	if (params->level == ZCOMP_PARAM_NOT_SET)
 		params->level = zstd_default_clevel();
 
@@ -113,6 +144,7 @@ static void zstd_destroy(struct zcomp_ctx *ctx)
 	else
 		zstd_free_dctx(zctx->dctx);
 
+	zstd_free_cctx(zctx->live_cctx);
 	kfree(zctx);
 }
 
@@ -166,14 +198,116 @@ static int zstd_create(struct zcomp_params *params, struct zcomp_ctx *ctx)
 	return -EINVAL;
 }
 
+/*
+ * ID of a dictionary in the zstd format, or 0 for raw content, which
+ * frames cannot refer to.
+ */
+static u32 zstd_dict_id(const void *dict, size_t dict_sz)
+{
+	if (dict_sz < 8 || get_unaligned_le32(dict) != ZSTD_MAGIC_DICTIONARY)
+		return 0;
+	return get_unaligned_le32(dict + 4);
+}
+
+static int zstd_add_dict(struct zcomp_params *params, void *dict,
+			 size_t dict_sz)
+{
+	struct zstd_params *zp = params->drv_data;
+	zstd_compression_parameters prm;
+	struct zstd_live_dict *ld;
+	unsigned int i;
+	u32 id;
+
+	/*
+	 * Frames compressed with the new dictionary must be told apart from
+	 * all earlier ones by the dictionary ID in their header.
+	 */
+	id = zstd_dict_id(dict, dict_sz);
+	if (!id)
+		return -EINVAL;
+
+	guard(mutex)(&zp->live_lock);
+	if (zp->nr_live == ZSTD_MAX_LIVE_DICTS)
+		return -ENOSPC;
+
+	if (id == zstd_dict_id(params->dict, params->dict_sz))
+		return -EEXIST;
+	for (i = 0; i < zp->nr_live; i++) {
+		if (zp->live[i].id == id)
+			return -EEXIST;
+	}
+
+	ld = &zp->live[zp->nr_live];
+	prm = zstd_get_cparams(params->level, PAGE_SIZE, dict_sz);
+	ld->cdict = zstd_create_cdict_byreference(dict, dict_sz, prm,
+						  zp->custom_mem);
+	ld->ddict = zstd_create_ddict_byreference(dict, dict_sz,
+						  zp->custom_mem);
+	if (!ld->cdict || !ld->ddict) {
+		zstd_free_cdict(ld->cdict);
+		zstd_free_ddict(ld->ddict);
+		ld->cdict = NULL;
+		ld->ddict = NULL;
+		return -ENOMEM;
+	}
+
+	ld->dict = dict;
+	ld->id = id;
+	smp_store_release(&zp->nr_live, zp->nr_live + 1);
+	return 0;
+}
+
+static struct zstd_live_dict *zstd_find_live_dict(struct zstd_params *zp,
+						  const void *src,
+						  size_t src_len)
+{
+	unsigned int i, nr_live = smp_load_acquire(&zp->nr_live);
+	zstd_frame_header fh;
+
+	if (!nr_live)
+		return NULL;
+
+	if (zstd_get_frame_header(&fh, src, src_len) || !fh.dictID)
+		return NULL;
+
+	for (i = 0; i < nr_live; i++) {
+		if (zp->live[i].id == fh.dictID)
+			return &zp->live[i];
+	}
+	return NULL;
+}
+
+/*
+ * Embedded contexts are sized for compression without a dictionary and
+ * cannot grow, so live dictionaries need a context of their own.
+ */
+static zstd_cctx *zstd_live_cctx(struct zstd_params *zp,
+				 struct zstd_ctx *zctx)
+{
+	if (!zctx->cctx_mem)
+		return zctx->cctx;
+
+	if (!zctx->live_cctx)
+		zctx->live_cctx = zstd_create_cctx_advanced(zp->custom_mem);
+	return zctx->live_cctx;
+}
+
 static int zstd_compress(struct zcomp_params *params, struct zcomp_ctx *ctx,
 			 struct zcomp_req *req)
 {
 	struct zstd_params *zp = params->drv_data;
 	struct zstd_ctx *zctx = ctx->context;
+	unsigned int nr_live = smp_load_acquire(&zp->nr_live);
+	zstd_cctx *cctx;
 	size_t ret;
 
-	if (params->dict_sz == 0)
+	/* Without memory for it, fall back to the initial parameters */
+	cctx = nr_live ? zstd_live_cctx(zp, zctx) : NULL;
+	if (cctx)
+		ret = zstd_compress_using_cdict(cctx, req->dst, req->dst_len,
+						req->src, req->src_len,
+						zp->live[nr_live - 1].cdict);
+	else if (params->dict_sz == 0)
 		ret = zstd_compress_cctx(zctx->cctx, req->dst, req->dst_len,
 					 req->src, req->src_len, &zp->cprm);
 	else
@@ -192,9 +326,15 @@ static int zstd_decompress(struct zcomp_params *params, struct zcomp_ctx *ctx,
 {
 	struct zstd_params *zp = params->drv_data;
 	struct zstd_ctx *zctx = ctx->context;
+	struct zstd_live_dict *ld;
 	size_t ret;
 
-	if (params->dict_sz == 0)
+	ld = zstd_find_live_dict(zp, req->src, req->src_len);
+	if (ld)
+		ret = zstd_decompress_using_ddict(zctx->dctx, req->dst,
+						  req->dst_len, req->src,
+						  req->src_len, ld->ddict);
+	else if (params->dict_sz == 0)
 		ret = zstd_decompress_dctx(zctx->dctx, req->dst, req->dst_len,
 					   req->src, req->src_len);
 	else
@@ -213,5 +353,6 @@ const struct zcomp_ops backend_zstd = {
 	.destroy_ctx	= zstd_destroy,
 	.setup_params	= zstd_setup_params,
 	.release_params	= zstd_release_params,
+	.add_dict	= zstd_add_dict,
 	.name		= "zstd",
 };
@@ -166,6 +166,13 @@ int zcomp_decompress(struct zcomp *comp, struct zcomp_strm *zstrm,
 	return comp->ops->decompress(comp->params, &zstrm->ctx, &req);
 }
 
+int zcomp_add_dict(struct zcomp *comp, void *dict, size_t dict_sz)
+{
+	if (!comp->ops->add_dict)
+		return -EOPNOTSUPP;
+	return comp->ops->add_dict(comp->params, dict, dict_sz);
+}
+
 int zcomp_cpu_up_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zcomp *comp = hlist_entry(node, struct zcomp, node);
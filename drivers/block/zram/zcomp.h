@@ -66,6 +66,14 @@ struct zcomp_ops {
 	int (*setup_params)(struct zcomp_params *params);
 	void (*release_params)(struct zcomp_params *params);
 
+	/*
+	 * Optional: switch compression of a live comp to @dict while data
+	 * compressed earlier stays decodable. On success the backend owns
+	 * @dict (vmalloc-ed) and frees it in ->release_params().
+	 */
+	int (*add_dict)(struct zcomp_params *params, void *dict,
+			size_t dict_sz);
+
 	const char *name;
 };
 
@@ -92,5 +100,6 @@ int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
 		   const void *src, unsigned int *dst_len);
 int zcomp_decompress(struct zcomp *comp, struct zcomp_strm *zstrm,
 		     const void *src, unsigned int src_len, void *dst);
+int zcomp_add_dict(struct zcomp *comp, void *dict, size_t dict_sz);
 
 #endif /* _ZCOMP_H_ */
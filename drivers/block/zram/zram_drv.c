@@ -33,6 +33,7 @@
 #include <linux/cpuhotplug.h>
 #include <linux/part_stat.h>
 #include <linux/kernel_read_file.h>
+#include <linux/xxhash.h>
 
 #include "zram_drv.h"
 
@@ -134,6 +135,16 @@ static bool test_slot_flag(struct zram *zram, u32 index,
 	return zram->table[index].attr.flags & BIT(flag);
 }
 
+/* zsmalloc handle of the slot object, which may be shared */
+static unsigned long get_slot_zs_handle(struct zram *zram, u32 index)
+{
+	unsigned long handle = get_slot_handle(zram, index);
+
+	if (test_slot_flag(zram, index, ZRAM_DEDUP))
+		return ((struct zram_dedup_entry *)handle)->handle;
+	return handle;
+}
+
 static void set_slot_flag(struct zram *zram, u32 index,
 			  enum zram_pageflags flag)
 {
@@ -1712,6 +1723,43 @@ static int comp_params_store(struct zram *zram, u32 prio, s32 level,
 	return 0;
 }
 
+/*
+ * Switches an initialized device to a new dictionary. Pages written from
+ * now on are compressed with it, stored pages stay readable.
+ */
+static int comp_dict_switch(struct zram *zram, u32 prio, s32 level,
+			    const char *dict_path,
+			    struct deflate_params *deflate_params)
+{
+	void *dict = NULL;
+	ssize_t sz;
+	int ret;
+
+	if (!dict_path || level != ZCOMP_PARAM_NOT_SET ||
+	    deflate_params->winbits != ZCOMP_PARAM_NOT_SET ||
+	    !zram->comps[prio])
+		return -EBUSY;
+
+	sz = kernel_read_file_from_path(dict_path, 0, &dict, INT_MAX, NULL,
+					READING_POLICY);
+	if (sz < 0)
+		return -EINVAL;
+
+	ret = zcomp_add_dict(zram->comps[prio], dict, sz);
+	if (ret) {
+		vfree(dict);
+		return ret;
+	}
+
+	if (prio == ZRAM_PRIMARY_COMP) {
+		atomic64_set(&zram->stats.comp_pages, 0);
+		atomic64_set(&zram->stats.comp_out_size, 0);
+		atomic64_set(&zram->stats.comp_time_ns, 0);
+		WRITE_ONCE(zram->comp_stats, true);
+	}
+	return 0;
+}
+
 static ssize_t algorithm_params_store(struct device *dev,
 				      struct device_attribute *attr,
 				      const char *buf,
@@ -1783,7 +1831,13 @@ static ssize_t algorithm_params_store(struct device *dev,
 	if (prio < ZRAM_PRIMARY_COMP || prio >= ZRAM_MAX_COMPS)
 		return -EINVAL;
 
-	ret = comp_params_store(zram, prio, level, dict_path, &deflate_params);
+	guard(rwsem_write)(&zram->dev_lock);
+	if (init_done(zram))
+		ret = comp_dict_switch(zram, prio, level, dict_path,
+				       &deflate_params);
+	else
+		ret = comp_params_store(zram, prio, level, dict_path,
+					&deflate_params);
 	return ret ? ret : len;
 }
 
@@ -1924,7 +1978,8 @@ static ssize_t mm_stat_show(struct device *dev, struct device_attribute *attr,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = sysfs_emit(buf,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu "
+			"%8llu %8llu %8llu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -1933,7 +1988,13 @@ static ssize_t mm_stat_show(struct device *dev, struct device_attribute *attr,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			atomic_long_read(&pool_stats.pages_compacted),
 			(u64)atomic64_read(&zram->stats.huge_pages),
-			(u64)atomic64_read(&zram->stats.huge_pages_since));
+			(u64)atomic64_read(&zram->stats.huge_pages_since),
+			(u64)atomic64_read(&zram->stats.dup_pages),
+			(u64)atomic64_read(&zram->stats.dup_data_size),
+			(u64)atomic64_read(&zram->stats.dup_collisions),
+			(u64)atomic64_read(&zram->stats.comp_pages),
+			(u64)atomic64_read(&zram->stats.comp_out_size),
+			(u64)atomic64_read(&zram->stats.comp_time_ns));
 
 	return ret;
 }
@@ -1954,6 +2015,189 @@ static ssize_t debug_stat_show(struct device *dev,
 	return ret;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static const struct rhashtable_params zram_dedup_params = {
+	.key_len		= sizeof(u64),
+	.key_offset		= offsetof(struct zram_dedup_entry, checksum),
+	.head_offset		= offsetof(struct zram_dedup_entry, node),
+	.automatic_shrinking	= true,
+};
+
+static ssize_t dedup_enable_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	if (kstrtobool(buf, &val))
+		return -EINVAL;
+
+	guard(rwsem_write)(&zram->dev_lock);
+	if (init_done(zram))
+		return -EBUSY;
+
+	zram->dedup_enable = val;
+
+	return len;
+}
+
+static ssize_t dedup_enable_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	guard(rwsem_read)(&zram->dev_lock);
+	val = zram->dedup_enable;
+
+	return sysfs_emit(buf, "%d\n", val);
+}
+
+static int zram_dedup_init(struct zram *zram)
+{
+	if (!zram->dedup_enable)
+		return 0;
+	return rhltable_init(&zram->dedup_table, &zram_dedup_params);
+}
+
+static void zram_dedup_destroy(struct zram *zram)
+{
+	/* All entries are gone once every slot has been freed */
+	if (zram->dedup_enable)
+		rhltable_destroy(&zram->dedup_table);
+}
+
+/* Returns true if this was the last reference and the object is gone */
+static bool zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry)
+{
+	if (!refcount_dec_and_test(&entry->refcount))
+		return false;
+
+	rhltable_remove(&zram->dedup_table, &entry->node, zram_dedup_params);
+	zs_free(zram->mem_pool, entry->handle);
+	atomic64_sub(entry->len, &zram->stats.compr_data_size);
+	kfree_rcu(entry, rcu);
+	return true;
+}
+
+/*
+ * Compares @mem with the object of @entry. The caller holds the primary
+ * stream, whose compression buffer is not in use yet and receives the
+ * decompressed candidate.
+ */
+static bool zram_dedup_match(struct zram *zram, struct zcomp_strm *zstrm,
+			     struct zram_dedup_entry *entry, void *mem)
+{
+	bool match = false;
+	void *src;
+
+	src = zs_obj_read_begin(zram->mem_pool, entry->handle, entry->len,
+				zstrm->local_copy);
+	if (entry->len == PAGE_SIZE)
+		match = !memcmp(src, mem, PAGE_SIZE);
+	else if (!zcomp_decompress(zram->comps[ZRAM_PRIMARY_COMP], zstrm,
+				   src, entry->len, zstrm->buffer))
+		match = !memcmp(zstrm->buffer, mem, PAGE_SIZE);
+	zs_obj_read_end(zram->mem_pool, entry->handle, entry->len, src);
+
+	return match;
+}
+
+/*
+ * Hashes the page at @mem into @checksum and looks for a stored object
+ * with the same content. Returns that object with a reference held.
+ */
+static struct zram_dedup_entry *zram_dedup_find(struct zram *zram,
+						struct zcomp_strm *zstrm,
+						void *mem, u64 *checksum)
+{
+	struct zram_dedup_entry *entry, *found = NULL;
+	struct rhlist_head *list, *pos;
+	unsigned int len;
+
+	if (!zram->dedup_enable)
+		return NULL;
+
+	*checksum = xxh64(mem, PAGE_SIZE, 0);
+
+	rcu_read_lock();
+	list = rhltable_lookup(&zram->dedup_table, checksum,
+			       zram_dedup_params);
+	rhl_for_each_entry_rcu(entry, pos, list, node) {
+		if (refcount_inc_not_zero(&entry->refcount)) {
+			found = entry;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	if (!found || zram_dedup_match(zram, zstrm, found, mem))
+		return found;
+
+	atomic64_inc(&zram->stats.dup_collisions);
+	/*
+	 * If ours was the last reference, the slot that dropped the one
+	 * before us was accounted as a duplicate going away, so undo that.
+	 */
+	len = found->len;
+	if (zram_dedup_put(zram, found)) {
+		atomic64_inc(&zram->stats.dup_pages);
+		atomic64_add(len, &zram->stats.dup_data_size);
+	}
+	return NULL;
+}
+
+/* Makes a newly stored object available for sharing */
+static struct zram_dedup_entry *zram_dedup_insert(struct zram *zram,
+						  unsigned long handle,
+						  unsigned int len, u64 checksum)
+{
+	struct zram_dedup_entry *entry;
+
+	if (!zram->dedup_enable)
+		return NULL;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->checksum = checksum;
+	entry->handle = handle;
+	entry->len = len;
+	refcount_set(&entry->refcount, 1);
+	if (rhltable_insert(&zram->dedup_table, &entry->node,
+			    zram_dedup_params)) {
+		kfree(entry);
+		return NULL;
+	}
+
+	return entry;
+}
+#else
+static inline int zram_dedup_init(struct zram *zram) { return 0; }
+static inline void zram_dedup_destroy(struct zram *zram) {};
+static inline bool zram_dedup_put(struct zram *zram,
+				  struct zram_dedup_entry *entry)
+{
+	return false;
+}
+
+static inline struct zram_dedup_entry *
+zram_dedup_find(struct zram *zram, struct zcomp_strm *zstrm, void *mem,
+		u64 *checksum)
+{
+	return NULL;
+}
+
+static inline struct zram_dedup_entry *
+zram_dedup_insert(struct zram *zram, unsigned long handle, unsigned int len,
+		  u64 checksum)
+{
+	return NULL;
+}
+#endif
+
 static void zram_meta_free(struct zram *zram, u64 disksize)
 {
 	size_t num_pages = disksize >> PAGE_SHIFT;
@@ -1966,6 +2210,7 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	for (index = 0; index < num_pages; index++)
 		slot_free(zram, index);
 
+	zram_dedup_destroy(zram);
 	zs_destroy_pool(zram->mem_pool);
 	vfree(zram->table);
 	zram->table = NULL;
@@ -1987,6 +2232,13 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 		return false;
 	}
 
+	if (zram_dedup_init(zram)) {
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		zram->table = NULL;
+		return false;
+	}
+
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 
@@ -2034,6 +2286,17 @@ static void slot_free(struct zram *zram, u32 index)
 	if (!handle)
 		return;
 
+	/* Shared objects are released and accounted with the last user */
+	if (test_slot_flag(zram, index, ZRAM_DEDUP)) {
+		clear_slot_flag(zram, index, ZRAM_DEDUP);
+		if (!zram_dedup_put(zram, (struct zram_dedup_entry *)handle)) {
+			atomic64_dec(&zram->stats.dup_pages);
+			atomic64_sub(get_slot_size(zram, index),
+				     &zram->stats.dup_data_size);
+		}
+		goto out;
+	}
+
 	zs_free(zram->mem_pool, handle);
 
 	atomic64_sub(get_slot_size(zram, index),
@@ -2061,7 +2324,7 @@ static int read_incompressible_page(struct zram *zram, struct page *page,
 	unsigned long handle;
 	void *src, *dst;
 
-	handle = get_slot_handle(zram, index);
+	handle = get_slot_zs_handle(zram, index);
 	src = zs_obj_read_begin(zram->mem_pool, handle, PAGE_SIZE, NULL);
 	dst = kmap_local_page(page);
 	copy_page(dst, src);
@@ -2079,7 +2342,7 @@ static int read_compressed_page(struct zram *zram, struct page *page, u32 index)
 	void *src, *dst;
 	int ret, prio;
 
-	handle = get_slot_handle(zram, index);
+	handle = get_slot_zs_handle(zram, index);
 	size = get_slot_size(zram, index);
 	prio = get_slot_comp_priority(zram, index);
 
@@ -2103,7 +2366,7 @@ static int read_from_zspool_raw(struct zram *zram, struct page *page, u32 index)
 	unsigned int size;
 	void *src;
 
-	handle = get_slot_handle(zram, index);
+	handle = get_slot_zs_handle(zram, index);
 	size = get_slot_size(zram, index);
 
 	/*
@@ -2208,9 +2471,43 @@ static int write_same_filled_page(struct zram *zram, unsigned long fill,
 	return 0;
 }
 
+static void set_slot_object(struct zram *zram, u32 index,
+			    unsigned long handle,
+			    struct zram_dedup_entry *entry)
+{
+	if (entry) {
+		set_slot_flag(zram, index, ZRAM_DEDUP);
+		handle = (unsigned long)entry;
+	}
+	set_slot_handle(zram, index, handle);
+}
+
+static int write_dedup_page(struct zram *zram, struct zram_dedup_entry *entry,
+			    u32 index)
+{
+	unsigned int len = entry->len;
+
+	slot_lock(zram, index);
+	slot_free(zram, index);
+	if (len == PAGE_SIZE)
+		set_slot_flag(zram, index, ZRAM_HUGE);
+	set_slot_object(zram, index, entry->handle, entry);
+	set_slot_size(zram, index, len);
+	slot_unlock(zram, index);
+
+	if (len == PAGE_SIZE)
+		atomic64_inc(&zram->stats.huge_pages);
+	atomic64_inc(&zram->stats.dup_pages);
+	atomic64_add(len, &zram->stats.dup_data_size);
+	atomic64_inc(&zram->stats.pages_stored);
+
+	return 0;
+}
+
 static int write_incompressible_page(struct zram *zram, struct page *page,
-				     u32 index)
+				     u32 index, u64 checksum)
 {
+	struct zram_dedup_entry *entry;
 	unsigned long handle;
 	void *src;
 
@@ -2234,10 +2531,12 @@ static int write_incompressible_page(struct zram *zram, struct page *page,
 	zs_obj_write(zram->mem_pool, handle, src, PAGE_SIZE);
 	kunmap_local(src);
 
+	entry = zram_dedup_insert(zram, handle, PAGE_SIZE, checksum);
+
 	slot_lock(zram, index);
 	slot_free(zram, index);
 	set_slot_flag(zram, index, ZRAM_HUGE);
-	set_slot_handle(zram, index, handle);
+	set_slot_object(zram, index, handle, entry);
 	set_slot_size(zram, index, PAGE_SIZE);
 	slot_unlock(zram, index);
 
@@ -2256,8 +2555,12 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	unsigned int comp_len;
 	void *mem;
 	struct zcomp_strm *zstrm;
+	struct zram_dedup_entry *entry;
 	unsigned long element;
+	u64 checksum = 0;
 	bool same_filled;
+	bool comp_stats;
+	u64 start = 0;
 
 	mem = kmap_local_page(page);
 	same_filled = page_same_filled(mem, &element);
@@ -2267,6 +2570,16 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 
 	zstrm = zcomp_stream_get(zram->comps[ZRAM_PRIMARY_COMP]);
 	mem = kmap_local_page(page);
+	entry = zram_dedup_find(zram, zstrm, mem, &checksum);
+	if (entry) {
+		kunmap_local(mem);
+		zcomp_stream_put(zstrm);
+		return write_dedup_page(zram, entry, index);
+	}
+
+	comp_stats = READ_ONCE(zram->comp_stats);
+	if (unlikely(comp_stats))
+		start = ktime_get_ns();
 	ret = zcomp_compress(zram->comps[ZRAM_PRIMARY_COMP], zstrm,
 			     mem, &comp_len);
 	kunmap_local(mem);
@@ -2277,9 +2590,17 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 		return ret;
 	}
 
+	if (unlikely(comp_stats)) {
+		atomic64_add(ktime_get_ns() - start,
+			     &zram->stats.comp_time_ns);
+		atomic64_add(min_t(unsigned int, comp_len, PAGE_SIZE),
+			     &zram->stats.comp_out_size);
+		atomic64_inc(&zram->stats.comp_pages);
+	}
+
 	if (comp_len >= huge_class_size) {
 		zcomp_stream_put(zstrm);
-		return write_incompressible_page(zram, page, index);
+		return write_incompressible_page(zram, page, index, checksum);
 	}
 
 	handle = zs_malloc(zram->mem_pool, comp_len,
@@ -2299,9 +2620,11 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	zs_obj_write(zram->mem_pool, handle, zstrm->buffer, comp_len);
 	zcomp_stream_put(zstrm);
 
+	entry = zram_dedup_insert(zram, handle, comp_len, checksum);
+
 	slot_lock(zram, index);
 	slot_free(zram, index);
-	set_slot_handle(zram, index, handle);
+	set_slot_object(zram, index, handle, entry);
 	set_slot_size(zram, index, comp_len);
 	slot_unlock(zram, index);
 
@@ -2345,6 +2668,22 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 #define RECOMPRESS_IDLE		(1 << 0)
 #define RECOMPRESS_HUGE		(1 << 1)
 
+/*
+ * A deduplicated object with other users would have to be replaced for all
+ * of them. One with a single owner is recompressed like any other object;
+ * slot_free() drops its dedup entry, so the result is never shared.
+ */
+static bool slot_object_shared(struct zram *zram, u32 index)
+{
+	struct zram_dedup_entry *entry;
+
+	if (!test_slot_flag(zram, index, ZRAM_DEDUP))
+		return false;
+
+	entry = (struct zram_dedup_entry *)get_slot_handle(zram, index);
+	return refcount_read(&entry->refcount) > 1;
+}
+
 static int scan_slots_for_recompress(struct zram *zram, u32 mode, u32 prio_max,
 				     struct zram_pp_ctl *ctl)
 {
@@ -2368,7 +2707,8 @@ static int scan_slots_for_recompress(struct zram *zram, u32 mode, u32 prio_max,
 
 		if (test_slot_flag(zram, index, ZRAM_WB) ||
 		    test_slot_flag(zram, index, ZRAM_SAME) ||
-		    test_slot_flag(zram, index, ZRAM_INCOMPRESSIBLE))
+		    test_slot_flag(zram, index, ZRAM_INCOMPRESSIBLE) ||
+		    slot_object_shared(zram, index))
 			goto next;
 
 		/* Already compressed with same of higher priority */
@@ -2410,6 +2750,10 @@ static int recompress_slot(struct zram *zram, u32 index, struct page *page,
 	if (!handle_old)
 		return -EINVAL;
 
+	/* The object may have been shared since the slot was scanned */
+	if (slot_object_shared(zram, index))
+		return 0;
+
 	comp_len_old = get_slot_size(zram, index);
 	/*
 	 * Do not recompress objects that are already "small enough".
@@ -2875,6 +3219,7 @@ static void zram_reset_device(struct zram *zram)
 	zram->disksize = 0;
 	zram_destroy_comps(zram);
 	memset(&zram->stats, 0, sizeof(zram->stats));
+	zram->comp_stats = false;
 	reset_bdev(zram);
 
 	comp_algorithm_set(zram, ZRAM_PRIMARY_COMP, default_compressor);
@@ -3014,6 +3359,9 @@ static DEVICE_ATTR_RW(recomp_algorithm);
 static DEVICE_ATTR_WO(recompress);
 #endif
 static DEVICE_ATTR_WO(algorithm_params);
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(dedup_enable);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -3041,6 +3389,9 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_recompress.attr,
 #endif
 	&dev_attr_algorithm_params.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_dedup_enable.attr,
+#endif
 	NULL,
 };
 
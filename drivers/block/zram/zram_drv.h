@@ -15,6 +15,8 @@
 #ifndef _ZRAM_DRV_H_
 #define _ZRAM_DRV_H_
 
+#include <linux/refcount.h>
+#include <linux/rhashtable.h>
 #include <linux/rwsem.h>
 #include <linux/zsmalloc.h>
 
@@ -50,6 +52,7 @@ enum zram_pageflags {
 	ZRAM_HUGE,	/* Incompressible page */
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
 	ZRAM_INCOMPRESSIBLE, /* none of the algorithms could compress it */
+	ZRAM_DEDUP,	/* handle points to a shared zram_dedup_entry */
 
 	ZRAM_COMP_PRIORITY_BIT1, /* First bit of comp priority index */
 	ZRAM_COMP_PRIORITY_BIT2, /* Second bit of comp priority index */
@@ -77,6 +80,20 @@ struct zram_table_entry {
 	struct lockdep_map dep_map;
 };
 
+/*
+ * zsmalloc object shared by all slots that stored the same content.
+ * ZRAM_DEDUP slots keep a pointer to it in their handle and hold one
+ * reference each; the object is freed with the last reference.
+ */
+struct zram_dedup_entry {
+	struct rhlist_head node;
+	u64 checksum;
+	unsigned long handle;
+	unsigned int len;
+	refcount_t refcount;
+	struct rcu_head rcu;
+};
+
 struct zram_stats {
 	atomic64_t compr_data_size;	/* compressed size of pages stored */
 	atomic64_t failed_reads;	/* can happen when memory is too low */
@@ -88,6 +105,13 @@ struct zram_stats {
 	atomic64_t pages_stored;	/* no. of pages currently stored */
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t miss_free;		/* no. of missed free */
+	atomic64_t dup_pages;		/* no. of pages sharing a stored object */
+	atomic64_t dup_data_size;	/* compressed size saved by sharing */
+	atomic64_t dup_collisions;	/* no. of checksum hits on other data */
+	/* primary compression since the last dictionary switch */
+	atomic64_t comp_pages;		/* no. of pages compressed */
+	atomic64_t comp_out_size;	/* their compressed size */
+	atomic64_t comp_time_ns;	/* time spent compressing them */
 #ifdef	CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
@@ -130,6 +154,8 @@ struct zram {
 	 * zram is claimed so open request will be failed
 	 */
 	bool claim; /* Protected by disk->open_mutex */
+	/* time primary compression, set once a dictionary was switched */
+	bool comp_stats;
 #ifdef CONFIG_ZRAM_WRITEBACK
 	struct file *backing_dev;
 	bool wb_limit_enable;
@@ -140,6 +166,10 @@ struct zram {
 	unsigned long *bitmap;
 	unsigned long nr_pages;
 #endif
+#ifdef CONFIG_ZRAM_DEDUP
+	bool dedup_enable;
+	struct rhltable dedup_table;
+#endif
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	struct dentry *debugfs_dir;
 #endif
@@ -117,6 +117,7 @@ struct netdevsim {
 		struct psp_dev *dev;
 		u32 spi;
 		u32 assoc_cnt;
+		bool sw_crypto;
 	} psp;
 
 	struct nsim_bus_dev *nsim_bus_dev;
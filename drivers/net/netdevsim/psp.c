@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: GPL-2.0
 
+#include <crypto/aead.h>
 #include <linux/ip.h>
 #include <linux/skbuff.h>
 #include <net/ip6_checksum.h>
@@ -8,20 +9,124 @@
 
 #include "netdevsim.h"
 
+struct nsim_psp_assoc {
+	struct netdevsim *ns;
+	struct crypto_aead __rcu *tfm;	/* only with psp_sw_crypto */
+	atomic64_t iv;
+};
+
 void nsim_psp_handle_ext(struct sk_buff *skb, struct skb_ext *psp_ext)
 {
 	if (psp_ext)
 		__skb_ext_set(skb, SKB_EXT_PSP, psp_ext);
 }
 
+static struct crypto_aead *nsim_psp_tfm_alloc(struct psp_assoc *pas)
+{
+	struct crypto_aead *tfm;
+	int err;
+
+	/* Must not go async, we run from ndo_start_xmit */
+	tfm = crypto_alloc_aead("gcm(aes)", 0, CRYPTO_ALG_ASYNC);
+	if (IS_ERR(tfm))
+		return tfm;
+
+	err = crypto_aead_setkey(tfm, pas->tx.key, psp_key_size(pas->version));
+	if (!err)
+		err = crypto_aead_setauthsize(tfm, PSP_TRL_SIZE);
+	if (err) {
+		crypto_free_aead(tfm);
+		return ERR_PTR(err);
+	}
+
+	return tfm;
+}
+
+/* Do the AES-GCM work a PSP NIC would do for @skb: seal every segment
+ * (gso_size worth of payload, or the whole payload for non-GSO skbs) on
+ * "transmit" and open it again on "receive". Segments share one request
+ * and one bounce buffer. The skb itself is not modified apart from the
+ * IV, its frags may still be referenced by the socket's retransmit queue.
+ */
+static int nsim_psp_sw_crypt(struct sk_buff *skb, struct psp_assoc *pas,
+			     struct nsim_psp_assoc *nas,
+			     struct crypto_aead *tfm)
+{
+	bool gmac = pas->version == PSP_VERSION_HDR0_AES_GMAC_128 ||
+		    pas->version == PSP_VERSION_HDR0_AES_GMAC_256;
+	unsigned int off, end, seg_len, nsegs, len;
+	struct aead_request *req;
+	struct scatterlist sg;
+	struct psphdr *psph;
+	u64 first, seq;
+	u8 iv[12];
+	u8 *buf;
+	int err;
+
+	off = skb_transport_offset(skb) + sizeof(struct udphdr);
+	psph = (struct psphdr *)(skb->data + off);
+	off += PSP_HDR_SIZE;
+	end = skb->len;
+	if (off >= end)
+		return -EINVAL;
+
+	seg_len = skb_is_gso(skb) ? skb_shinfo(skb)->gso_size : end - off;
+	seg_len = min(seg_len, end - off);
+	nsegs = DIV_ROUND_UP(end - off, seg_len);
+
+	buf = kmalloc(PSP_HDR_SIZE + seg_len + PSP_TRL_SIZE, GFP_ATOMIC);
+	req = aead_request_alloc(tfm, GFP_ATOMIC);
+	if (!buf || !req) {
+		err = -ENOMEM;
+		goto out;
+	}
+	aead_request_set_callback(req, 0, NULL, NULL);
+
+	first = atomic64_add_return(nsegs, &nas->iv) - nsegs + 1;
+	memcpy(iv, &psph->spi, sizeof(psph->spi));
+
+	for (seq = first, err = 0; off < end && !err; off += len, seq++) {
+		len = min(seg_len, end - off);
+
+		psph->iv = cpu_to_be64(seq);
+		memcpy(buf, psph, PSP_HDR_SIZE);
+		memcpy(iv + sizeof(psph->spi), &psph->iv, sizeof(psph->iv));
+		err = skb_copy_bits(skb, off, buf + PSP_HDR_SIZE, len);
+		if (err)
+			break;
+
+		sg_init_one(&sg, buf, PSP_HDR_SIZE + len + PSP_TRL_SIZE);
+		if (gmac) {
+			aead_request_set_ad(req, PSP_HDR_SIZE + len);
+			aead_request_set_crypt(req, &sg, &sg, 0, iv);
+		} else {
+			aead_request_set_ad(req, PSP_HDR_SIZE);
+			aead_request_set_crypt(req, &sg, &sg, len, iv);
+		}
+		err = crypto_aead_encrypt(req);
+		if (err)
+			break;
+
+		aead_request_set_crypt(req, &sg, &sg,
+				       (gmac ? 0 : len) + PSP_TRL_SIZE, iv);
+		err = crypto_aead_decrypt(req);
+	}
+	psph->iv = cpu_to_be64(first);
+out:
+	aead_request_free(req);
+	kfree(buf);
+	return err;
+}
+
 enum skb_drop_reason
 nsim_do_psp(struct sk_buff *skb, struct netdevsim *ns,
 	    struct netdevsim *peer_ns, struct skb_ext **psp_ext)
 {
 	enum skb_drop_reason rc = 0;
+	struct nsim_psp_assoc *nas;
+	struct crypto_aead *tfm;
 	struct psp_assoc *pas;
 	struct net *net;
-	void **ptr;
 
 	rcu_read_lock();
 	pas = psp_skb_get_assoc_rcu(skb);
@@ -35,8 +140,8 @@ nsim_do_psp(struct sk_buff *skb, struct netdevsim *ns,
 		goto out_unlock;
 	}
 
-	ptr = psp_assoc_drv_data(pas);
-	if (*ptr != ns) {
+	nas = psp_assoc_drv_data(pas);
+	if (READ_ONCE(nas->ns) != ns) {
 		rc = SKB_DROP_REASON_PSP_OUTPUT;
 		goto out_unlock;
 	}
@@ -47,6 +152,12 @@ nsim_do_psp(struct sk_buff *skb, struct netdevsim *ns,
 		goto out_unlock;
 	}
 
+	tfm = rcu_dereference(nas->tfm);
+	if (tfm && nsim_psp_sw_crypt(skb, pas, nas, tfm)) {
+		rc = SKB_DROP_REASON_PSP_OUTPUT;
+		goto out_unlock;
+	}
+
 	/* Now pretend we just received this frame */
 	if (peer_ns->psp.dev->config.versions & (1 << pas->version)) {
 		bool strip_icv = false;
@@ -149,11 +260,22 @@ nsim_rx_spi_alloc(struct psp_dev *psd, u32 version,
 static int nsim_assoc_add(struct psp_dev *psd, struct psp_assoc *pas,
 			  struct netlink_ext_ack *extack)
 {
+	struct nsim_psp_assoc *nas = psp_assoc_drv_data(pas);
 	struct netdevsim *ns = psd->drv_priv;
-	void **ptr = psp_assoc_drv_data(pas);
+	struct crypto_aead *tfm = NULL;
+
+	if (ns->psp.sw_crypto) {
+		tfm = nsim_psp_tfm_alloc(pas);
+		if (IS_ERR(tfm)) {
+			NL_SET_ERR_MSG(extack, "Failed to set up software crypto");
+			return PTR_ERR(tfm);
+		}
+	}
+	atomic64_set(&nas->iv, 0);
+	rcu_assign_pointer(nas->tfm, tfm);
 
 	/* Copy drv_priv from psd to assoc */
-	*ptr = psd->drv_priv;
+	WRITE_ONCE(nas->ns, psd->drv_priv);
 	ns->psp.assoc_cnt++;
 
 	return 0;
@@ -166,11 +288,21 @@ static int nsim_key_rotate(struct psp_dev *psd, struct netlink_ext_ack *extack)
 
 static void nsim_assoc_del(struct psp_dev *psd, struct psp_assoc *pas)
 {
+	struct nsim_psp_assoc *nas = psp_assoc_drv_data(pas);
 	struct netdevsim *ns = psd->drv_priv;
-	void **ptr = psp_assoc_drv_data(pas);
+	struct crypto_aead *tfm;
 
-	*ptr = NULL;
+	tfm = rcu_replace_pointer(nas->tfm, NULL, lockdep_is_held(&psd->lock));
+	WRITE_ONCE(nas->ns, NULL);
 	ns->psp.assoc_cnt--;
+
+	/* The association outlives this call, nsim_do_psp() may still be
+	 * encrypting with the old tfm.
+	 */
+	if (tfm) {
+		synchronize_net();
+		crypto_free_aead(tfm);
+	}
 }
 
 static void nsim_get_stats(struct psp_dev *psd, struct psp_dev_stats *stats)
@@ -206,7 +338,7 @@ static struct psp_dev_caps nsim_psp_caps = {
 		    1 << PSP_VERSION_HDR0_AES_GMAC_128 |
 		    1 << PSP_VERSION_HDR0_AES_GCM_256 |
 		    1 << PSP_VERSION_HDR0_AES_GMAC_256,
-	.assoc_drv_spc = sizeof(void *),
+	.assoc_drv_spc = sizeof(struct nsim_psp_assoc),
 };
 
 void nsim_psp_uninit(struct netdevsim *ns)
@@ -250,5 +382,6 @@ int nsim_psp_init(struct netdevsim *ns)
 		return err;
 
 	debugfs_create_file("psp_rereg", 0200, ddir, ns, &nsim_psp_rereg_fops);
+	debugfs_create_bool("psp_sw_crypto", 0600, ddir, &ns->psp.sw_crypto);
 	return 0;
 }
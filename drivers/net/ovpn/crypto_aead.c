@@ -8,6 +8,7 @@
  */
 
 #include <crypto/aead.h>
+#include <linux/moduleparam.h>
 #include <linux/skbuff.h>
 #include <net/ip.h>
 #include <net/ipv6.h>
@@ -29,6 +30,17 @@
 #define ALG_NAME_AES		"gcm(aes)"
 #define ALG_NAME_CHACHAPOLY	"rfc7539(chacha20,poly1305)"
 
+/* When set, keys installed from now on have their AEADs wrapped in pcrypt,
+ * so that the packets of a single busy peer are encrypted and decrypted on
+ * all CPUs rather than on the one that happens to handle them. pcrypt
+ * serializes the completions, so packets still leave (or reach the device)
+ * in the order they were submitted.
+ */
+static bool parallel_crypto;
+module_param(parallel_crypto, bool, 0644);
+MODULE_PARM_DESC(parallel_crypto,
+		 "Parallelize data channel crypto across CPUs using pcrypt");
+
 static int ovpn_aead_encap_overhead(const struct ovpn_crypto_key_slot *ks)
 {
 	return  OVPN_OPCODE_SIZE +			/* OP header size */
@@ -156,6 +168,7 @@ int ovpn_aead_decrypt(struct ovpn_peer *peer, struct ovpn_crypto_key_slot *ks,
 	struct aead_request *req;
 	struct sk_buff *trailer;
 	struct scatterlist *sg;
+	__be32 *pid;
 	u8 *iv;
 
 	payload_offset = OVPN_AAD_SIZE + tag_size;
@@ -176,6 +189,15 @@ int ovpn_aead_decrypt(struct ovpn_peer *peer, struct ovpn_crypto_key_slot *ks,
 	if (unlikely(!pskb_may_pull(skb, payload_offset)))
 		return -ENODATA;
 
+	/* with pcrypt, don't spend a crypto worker on a packet that the
+	 * replay check in ovpn_decrypt_post() is bound to reject. Inline
+	 * decryption is cheaper than taking the replay window lock twice.
+	 */
+	pid = (__force __be32 *)(skb->data + OVPN_OPCODE_SIZE);
+	if (ks->parallel_decrypt &&
+	    unlikely(ovpn_pktid_recv_stale(&ks->pid_recv, ntohl(*pid))))
+		return -EINVAL;
+
 	/* get number of skb frags and ensure that packet data is writable */
 	nfrags = skb_cow_data(skb, 0, &trailer);
 	if (unlikely(nfrags < 0))
@@ -248,10 +270,17 @@ static struct crypto_aead *ovpn_aead_init(const char *title,
 					  const unsigned char *key,
 					  unsigned int keylen)
 {
+	char pname[CRYPTO_MAX_ALG_NAME];
 	struct crypto_aead *aead;
 	int ret;
 
-	aead = crypto_alloc_aead(alg_name, 0, 0);
+	aead = ERR_PTR(-ENOENT);
+	if (READ_ONCE(parallel_crypto) &&
+	    snprintf(pname, sizeof(pname), "pcrypt(%s)",
+		     alg_name) < sizeof(pname))
+		aead = crypto_alloc_aead(pname, 0, 0);
+	if (IS_ERR(aead))
+		aead = crypto_alloc_aead(alg_name, 0, 0);
 	if (IS_ERR(aead)) {
 		ret = PTR_ERR(aead);
 		pr_err("%s crypto_alloc_aead failed, err=%d\n", title, ret);
@@ -336,6 +365,7 @@ ovpn_aead_crypto_key_slot_new(const struct ovpn_key_config *kc)
 	ks->decrypt = NULL;
 	kref_init(&ks->refcount);
 	ks->key_id = kc->key_id;
+	ks->cipher_alg = kc->cipher_alg;
 
 	ks->encrypt = ovpn_aead_init("encrypt", alg_name,
 				     kc->encrypt.cipher_key,
@@ -354,6 +384,8 @@ ovpn_aead_crypto_key_slot_new(const struct ovpn_key_config *kc)
 		ks->decrypt = NULL;
 		goto destroy_ks;
 	}
+	ks->parallel_decrypt = !strncmp(crypto_aead_driver_name(ks->decrypt),
+					"pcrypt(", 7);
 
 	memcpy(ks->nonce_tail_xmit, kc->encrypt.nonce_tail,
 	       OVPN_NONCE_TAIL_SIZE);
@@ -373,17 +405,9 @@ ovpn_aead_crypto_key_slot_new(const struct ovpn_key_config *kc)
 
 enum ovpn_cipher_alg ovpn_aead_crypto_alg(struct ovpn_crypto_key_slot *ks)
 {
-	const char *alg_name;
-
+	/* the tfm name can't be used here, as it may be wrapped in pcrypt */
 	if (!ks->encrypt)
 		return OVPN_CIPHER_ALG_NONE;
 
-	alg_name = crypto_tfm_alg_name(crypto_aead_tfm(ks->encrypt));
-
-	if (!strcmp(alg_name, ALG_NAME_AES))
-		return OVPN_CIPHER_ALG_AES_GCM;
-	else if (!strcmp(alg_name, ALG_NAME_CHACHAPOLY))
-		return OVPN_CIPHER_ALG_CHACHA20_POLY1305;
-	else
-		return OVPN_CIPHER_ALG_NONE;
+	return ks->cipher_alg;
 }
@@ -127,3 +127,32 @@ int ovpn_pktid_recv(struct ovpn_pktid_recv *pr, u32 pkt_id, u32 pkt_time)
 	spin_unlock_bh(&pr->lock);
 	return ret;
 }
+
+/* Lookahead used before decryption: tell whether ovpn_pktid_recv() would
+ * reject @pkt_id as a replay, without updating the window. With parallel
+ * crypto, packets can be decrypted and checked out of order; anything within
+ * the backtrack window is still accepted once, exactly as in
+ * ovpn_pktid_recv(), which remains the authoritative check.
+ */
+bool ovpn_pktid_recv_stale(struct ovpn_pktid_recv *pr, u32 pkt_id)
+{
+	unsigned int delta, ri;
+	bool stale = false;
+
+	if (unlikely(pkt_id == 0))
+		return true;
+
+	spin_lock_bh(&pr->lock);
+	if (pkt_id <= pr->id) {
+		delta = pr->id - pkt_id;
+		if (delta >= pr->extent || pkt_id <= pr->id_floor) {
+			stale = true;
+		} else {
+			ri = REPLAY_INDEX(pr->base, delta);
+			stale = pr->history[ri / 8] & BIT(ri % 8);
+		}
+	}
+	spin_unlock_bh(&pr->lock);
+
+	return stale;
+}
@@ -82,5 +82,6 @@ void ovpn_pktid_xmit_init(struct ovpn_pktid_xmit *pid);
 void ovpn_pktid_recv_init(struct ovpn_pktid_recv *pr);
 
 int ovpn_pktid_recv(struct ovpn_pktid_recv *pr, u32 pkt_id, u32 pkt_time);
+bool ovpn_pktid_recv_stale(struct ovpn_pktid_recv *pr, u32 pkt_id);
 
 #endif /* _NET_OVPN_OVPNPKTID_H_ */
@@ -2178,8 +2178,8 @@ static int vxlan_build_gpe_hdr(struct vxlanhdr *vxh, __be16 protocol)
 	return 0;
 }
 
-static int vxlan_build_skb(struct sk_buff *skb, struct dst_entry *dst,
-			   int iphdr_len, __be32 vni,
+static int vxlan_build_skb(struct sk_buff *skb, struct net_device *dev,
+			   struct dst_entry *dst, int iphdr_len, __be32 vni,
 			   struct vxlan_metadata *md, u32 vxflags,
 			   bool udp_sum)
 {
@@ -2204,6 +2204,15 @@ static int vxlan_build_skb(struct sk_buff *skb, struct dst_entry *dst,
 	min_headroom = LL_RESERVED_SPACE(dst->dev) + dst->header_len
 			+ VXLAN_HLEN + iphdr_len;
 
+	/* The underlay may need more room than was reserved when the device
+	 * was set up (e.g. a VLAN or tunnel lower device picked by the
+	 * route).  Grow needed_headroom so that locally generated packets are
+	 * allocated large enough and skb_cow_head() below stays a no-op
+	 * instead of reallocating the head of every packet.
+	 */
+	if (min_headroom > READ_ONCE(dev->needed_headroom))
+		WRITE_ONCE(dev->needed_headroom, min_headroom);
+
 	/* Need space for new headers (invalidates iph ptr) */
 	err = skb_cow_head(skb, min_headroom);
 	if (unlikely(err))
@@ -2529,7 +2538,7 @@ void vxlan_xmit_one(struct sk_buff *skb, struct net_device *dev,
 
 		tos = ip_tunnel_ecn_encap(tos, old_iph, skb);
 		ttl = ttl ? : ip4_dst_hoplimit(&rt->dst);
-		err = vxlan_build_skb(skb, ndst, sizeof(struct iphdr),
+		err = vxlan_build_skb(skb, dev, ndst, sizeof(struct iphdr),
 				      vni, md, flags, udp_sum);
 		if (err < 0) {
 			reason = SKB_DROP_REASON_NOMEM;
@@ -2604,7 +2613,7 @@ void vxlan_xmit_one(struct sk_buff *skb, struct net_device *dev,
 		tos = ip_tunnel_ecn_encap(tos, old_iph, skb);
 		ttl = ttl ? : ip6_dst_hoplimit(ndst);
 		skb_scrub_packet(skb, xnet);
-		err = vxlan_build_skb(skb, ndst, sizeof(struct ipv6hdr),
+		err = vxlan_build_skb(skb, dev, ndst, sizeof(struct ipv6hdr),
 				      vni, md, flags, udp_sum);
 		if (err < 0) {
 			reason = SKB_DROP_REASON_NOMEM;
@@ -218,6 +218,134 @@ static bool encrypt_packet(struct sk_buff *skb, struct noise_keypair *keypair)
 						   keypair->sending.key);
 }
 
+/* Data messages of equal length that follow each other in a batch are
+ * encrypted into a single UDP GSO packet, so that the outer route, netfilter
+ * and qdisc are traversed once for the whole run rather than for each message.
+ * A shorter message may terminate a run, as with any UDP GSO packet. Messages
+ * are packed whole into order-0 pages, one page per frag.
+ */
+#define MAX_GSO_SEGMENTS 64
+#define MAX_GSO_PACKET_LEN \
+	(U16_MAX - sizeof(struct ipv6hdr) - sizeof(struct udphdr))
+
+static unsigned int gso_run_length(struct sk_buff *first, unsigned int *seg_len,
+				   unsigned int *total_len)
+{
+	unsigned int len, next_len, count = 1;
+	struct sk_buff *skb;
+
+	unsigned int used, frags = 1;
+
+	len = message_data_len(first->len + calculate_skb_padding(first));
+	if (len > PAGE_SIZE)
+		return 1;
+	*seg_len = *total_len = used = len;
+	for (skb = first->next; skb && count < MAX_GSO_SEGMENTS; skb = skb->next) {
+		next_len = message_data_len(skb->len + calculate_skb_padding(skb));
+		if (next_len > len || PACKET_CB(skb)->ds != PACKET_CB(first)->ds ||
+		    *total_len + next_len > MAX_GSO_PACKET_LEN)
+			break;
+		if (used + next_len > PAGE_SIZE) {
+			if (++frags > MAX_SKB_FRAGS)
+				break;
+			used = 0;
+		}
+		used += next_len;
+		*total_len += next_len;
+		++count;
+		if (next_len < len)
+			break;
+	}
+	return count;
+}
+
+static struct sk_buff *encrypt_gso_packets(struct sk_buff *first,
+					   struct noise_keypair *keypair)
+{
+	unsigned int count, seg_len, total_len, padding_len, plaintext_len, i;
+	unsigned int len, used = 0;
+	struct sk_buff *gso, *skb, *next, *last = first;
+	struct message_data *header;
+	struct page *page = NULL;
+
+	count = gso_run_length(first, &seg_len, &total_len);
+	if (count < 2)
+		return NULL;
+
+	gso = alloc_skb(DATA_PACKET_HEAD_ROOM, GFP_ATOMIC);
+	if (unlikely(!gso))
+		return NULL;
+	skb_reserve(gso, DATA_PACKET_HEAD_ROOM);
+
+	/* The plaintext is copied straight into the outgoing packet and
+	 * encrypted there, which replaces the copy that skb_cow_data() would
+	 * otherwise make of segments that share their frags.
+	 */
+	for (i = 0, skb = first; i < count; ++i, last = skb, skb = skb->next) {
+		padding_len = calculate_skb_padding(skb);
+		plaintext_len = skb->len + padding_len;
+		len = message_data_len(plaintext_len);
+
+		if (unlikely(skb->ip_summed == CHECKSUM_PARTIAL &&
+			     skb_checksum_help(skb)))
+			goto err;
+
+		if (!page || used + len > PAGE_SIZE) {
+			if (page)
+				skb_add_rx_frag(gso, skb_shinfo(gso)->nr_frags,
+						page, 0, used, PAGE_SIZE);
+			page = alloc_page(GFP_ATOMIC);
+			if (unlikely(!page))
+				goto err;
+			used = 0;
+		}
+
+		header = page_address(page) + used;
+		used += len;
+		header->header.type = cpu_to_le32(MESSAGE_DATA);
+		header->key_idx = keypair->remote_index;
+		header->counter = cpu_to_le64(PACKET_CB(skb)->nonce);
+		if (unlikely(skb_copy_bits(skb, 0, header->encrypted_data,
+					   skb->len)))
+			goto err;
+		memset(header->encrypted_data + skb->len, 0, padding_len);
+		chacha20poly1305_encrypt(header->encrypted_data,
+					 header->encrypted_data, plaintext_len,
+					 NULL, 0, PACKET_CB(skb)->nonce,
+					 keypair->sending.key);
+	}
+	skb_add_rx_frag(gso, skb_shinfo(gso)->nr_frags, page, 0, used,
+			PAGE_SIZE);
+	/* Like encrypt_packet(), for the tunnel's tx_bytes accounting. */
+	skb_set_inner_network_header(gso, sizeof(struct message_data));
+
+	skb_get_hash(first);
+	skb_copy_hash(gso, first);
+	*PACKET_CB(gso) = *PACKET_CB(first);
+
+	/* The UDP header is pushed right in front of the data by the tunnel
+	 * xmit helpers, which fill in the pseudo-header checksum for GSO.
+	 */
+	gso->ip_summed = CHECKSUM_PARTIAL;
+	gso->csum_start = skb_headroom(gso) - sizeof(struct udphdr);
+	gso->csum_offset = offsetof(struct udphdr, check);
+	skb_shinfo(gso)->gso_size = seg_len;
+	skb_shinfo(gso)->gso_segs = count;
+	skb_shinfo(gso)->gso_type = SKB_GSO_UDP_L4;
+
+	gso->next = last->next;
+	last->next = NULL;
+	skb_list_walk_safe(first, skb, next)
+		consume_skb(skb);
+	return gso;
+
+err:
+	if (page)
+		put_page(page);
+	kfree_skb(gso);
+	return NULL;
+}
+
 void wg_packet_send_keepalive(struct wg_peer *peer)
 {
 	struct sk_buff *skb;
@@ -288,14 +416,26 @@ void wg_packet_encrypt_worker(struct work_struct *work)
 {
 	struct crypt_queue *queue = container_of(work, struct multicore_worker,
 						 work)->ptr;
-	struct sk_buff *first, *skb, *next;
+	struct sk_buff *first, *skb, *prev, *gso;
 
 	while ((first = ptr_ring_consume_bh(&queue->ring)) != NULL) {
 		enum packet_state state = PACKET_STATE_CRYPTED;
+		struct noise_keypair *keypair = PACKET_CB(first)->keypair;
 
-		skb_list_walk_safe(first, skb, next) {
-			if (likely(encrypt_packet(skb,
-					PACKET_CB(first)->keypair))) {
+		/* The first skb stands for the whole batch in the peer's tx
+		 * queue, so it is always encrypted on its own; runs of the
+		 * ones after it may be merged into GSO packets.
+		 */
+		for (prev = NULL, skb = first; skb; prev = skb, skb = skb->next) {
+			if (prev) {
+				gso = encrypt_gso_packets(skb, keypair);
+				if (gso) {
+					prev->next = gso;
+					skb = gso;
+					continue;
+				}
+			}
+			if (likely(encrypt_packet(skb, keypair))) {
 				wg_reset_packet(skb, true);
 			} else {
 				state = PACKET_STATE_DEAD;
@@ -167,6 +167,7 @@ static int send6(struct wg_device *wg, struct sk_buff *skb,
 
 int wg_socket_send_skb_to_peer(struct wg_peer *peer, struct sk_buff *skb, u8 ds)
 {
+	unsigned int segs = skb_is_gso(skb) ? skb_shinfo(skb)->gso_segs : 1;
 	size_t skb_len = skb->len;
 	int ret = -EAFNOSUPPORT;
 
@@ -179,8 +180,12 @@ int wg_socket_send_skb_to_peer(struct wg_peer *peer, struct sk_buff *skb, u8 ds)
 			    &peer->endpoint_cache);
 	else
 		dev_kfree_skb(skb);
-	if (likely(!ret))
+	if (likely(!ret)) {
 		peer->tx_bytes += skb_len;
+		/* The tunnel xmit helpers count a GSO packet once. */
+		if (segs > 1)
+			dev_sw_netstats_tx_add(peer->device->dev, segs - 1, 0);
+	}
 	read_unlock_bh(&peer->endpoint_lock);
 
 	return ret;
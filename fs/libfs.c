@@ -1845,6 +1845,11 @@ int generic_ci_d_compare(const struct dentry *dentry, unsigned int len,
 		barrier();
 	}
 
+	if (utf8_is_ascii(qstr.name, qstr.len) &&
+	    utf8_is_ascii(name->name, name->len))
+		return qstr.len != name->len ||
+		       strncasecmp(qstr.name, name->name, qstr.len);
+
 	return utf8_strncasecmp(dentry->d_sb->s_encoding, name, &qstr);
 }
 EXPORT_SYMBOL(generic_ci_d_compare);
@@ -1866,6 +1871,11 @@ int generic_ci_d_hash(const struct dentry *dentry, struct qstr *str)
 	if (!dir || !IS_CASEFOLDED(dir))
 		return 0;
 
+	if (utf8_is_ascii(str->name, str->len)) {
+		utf8_casefold_hash_ascii(dentry, str);
+		return 0;
+	}
+
 	ret = utf8_casefold_hash(um, dentry, str);
 	if (ret < 0 && sb_has_strict_encoding(sb))
 		return -EINVAL;
@@ -1940,6 +1950,13 @@ int generic_ci_match(const struct inode *parent,
 	    !memcmp(name->name, dirent.name, dirent.len))
 		goto out;
 
+	if (utf8_is_ascii(name->name, name->len) &&
+	    utf8_is_ascii(dirent.name, dirent.len)) {
+		res = dirent.len != name->len ||
+		      strncasecmp(name->name, dirent.name, dirent.len);
+		goto out;
+	}
+
 	if (folded_name->name)
 		res = utf8_strncasecmp_folded(um, folded_name, &dirent);
 	else
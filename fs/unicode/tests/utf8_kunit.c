@@ -5,6 +5,7 @@
  * Copyright 2017 Collabora Ltd.
  */
 
+#include <linux/ktime.h>
 #include <linux/unicode.h>
 #include <kunit/test.h>
 
@@ -239,6 +240,70 @@ static void check_utf8_comparisons(struct kunit *test)
 	}
 }
 
+static const char * const ascii_test_names[] = {
+	"a", "Makefile", "README.md", "libGLESv2_adreno.so",
+	"IMG_20190101_123456.JPG", "0123456789-_.~!#$%&()+,;=@[]^`{}",
+};
+
+static void check_utf8_ascii_casefold(struct kunit *test)
+{
+	struct unicode_map *um = test->priv;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ascii_test_names); i++) {
+		struct qstr slow = QSTR(ascii_test_names[i]);
+		struct qstr fast = slow;
+
+		KUNIT_ASSERT_TRUE(test, utf8_is_ascii(fast.name, fast.len));
+		KUNIT_ASSERT_EQ(test, utf8_casefold_hash(um, NULL, &slow), 0);
+		utf8_casefold_hash_ascii(NULL, &fast);
+		KUNIT_EXPECT_EQ_MSG(test, fast.hash, slow.hash,
+				    "%s: ASCII hash differs from NFDICF hash\n",
+				    ascii_test_names[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(nfdicf_test_data); i++) {
+		struct qstr str = QSTR((const char *)nfdicf_test_data[i].str);
+		struct qstr ncf = QSTR((const char *)nfdicf_test_data[i].ncf);
+
+		if (!utf8_is_ascii(str.name, str.len))
+			continue;
+
+		utf8_casefold_hash_ascii(NULL, &str);
+		KUNIT_ASSERT_EQ(test, utf8_casefold_hash(um, NULL, &ncf), 0);
+		KUNIT_EXPECT_EQ_MSG(test, str.hash, ncf.hash,
+				    "%s: ASCII hash differs from folded hash\n",
+				    ncf.name);
+	}
+}
+
+#define CASEFOLD_BENCH_LOOPS	100000
+
+static void bench_utf8_casefold_hash(struct kunit *test)
+{
+	struct unicode_map *um = test->priv;
+	struct qstr name = QSTR("libGLESv2_adreno.so");
+	u64 slow_ns, fast_ns;
+	ktime_t start;
+	int i;
+
+	start = ktime_get();
+	for (i = 0; i < CASEFOLD_BENCH_LOOPS; i++)
+		utf8_casefold_hash(um, NULL, &name);
+	slow_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < CASEFOLD_BENCH_LOOPS; i++) {
+		if (utf8_is_ascii(name.name, name.len))
+			utf8_casefold_hash_ascii(NULL, &name);
+	}
+	fast_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	kunit_info(test, "casefold hash of \"%s\": utf8 %llu ns/op, ascii %llu ns/op\n",
+		   name.name, div_u64(slow_ns, CASEFOLD_BENCH_LOOPS),
+		   div_u64(fast_ns, CASEFOLD_BENCH_LOOPS));
+}
+
 static void check_supported_versions(struct kunit *test)
 {
 	struct unicode_map *um = test->priv;
@@ -262,6 +327,8 @@ static struct kunit_case unicode_normalization_test_cases[] = {
 	KUNIT_CASE(check_utf8_comparisons),
 	KUNIT_CASE(check_utf8_nfdicf),
 	KUNIT_CASE(check_utf8_nfdi),
+	KUNIT_CASE(check_utf8_ascii_casefold),
+	KUNIT_CASE_SLOW(bench_utf8_casefold_hash),
 	{}
 };
 
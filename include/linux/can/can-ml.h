@@ -55,6 +55,9 @@
 #define CAN_SFF_RCV_ARRAY_SZ (1 << CAN_SFF_ID_BITS)
 #define CAN_EFF_RCV_HASH_BITS 10
 #define CAN_EFF_RCV_ARRAY_SZ (1 << CAN_EFF_RCV_HASH_BITS)
+#define CAN_FIL_RCV_HASH_BITS 6
+#define CAN_FIL_RCV_ARRAY_SZ (1 << CAN_FIL_RCV_HASH_BITS)
+#define CAN_FIL_RCV_HASH_MASK (CAN_FIL_RCV_ARRAY_SZ - 1)
 
 enum { RX_ERR, RX_ALL, RX_FIL, RX_INV, RX_MAX };
 
@@ -62,6 +65,7 @@ struct can_dev_rcv_lists {
 	struct hlist_head rx[RX_MAX];
 	struct hlist_head rx_sff[CAN_SFF_RCV_ARRAY_SZ];
 	struct hlist_head rx_eff[CAN_EFF_RCV_ARRAY_SZ];
+	struct hlist_head rx_fil[CAN_FIL_RCV_ARRAY_SZ];
 	int entries;
 };
 
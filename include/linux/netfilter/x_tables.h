@@ -254,6 +254,9 @@ struct xt_table_info {
 	unsigned int stacksize;
 	void ***jumpstack;
 
+	/* Optional rule lookup index, see xt_rule_index_build() */
+	struct xt_rule_index *rule_index;
+
 	unsigned char entries[] __aligned(8);
 };
 
@@ -325,6 +328,65 @@ void xt_proto_fini(struct net *net, u_int8_t af);
 struct xt_table_info *xt_alloc_table_info(unsigned int size);
 void xt_free_table_info(struct xt_table_info *info);
 
+#define XT_RULE_INDEX_MAX_TUPLES	32
+#define XT_RULE_INDEX_MAX_WORDS		8
+#define XT_RULE_INDEX_NONE		U32_MAX
+
+/**
+ * struct xt_rule_index_ops - how a table family feeds xt_rule_index_build()
+ * @key_words: size of the packet key, in 32 bit words
+ * @entry_size: size of the table entry at @entry, rule or not
+ * @rule_key: returns false if @entry is not a rule (e.g. a chain header).
+ *	Otherwise fills in @mask and @val so that only packets whose key
+ *	equals @val under @mask can match the rule.
+ */
+struct xt_rule_index_ops {
+	unsigned int	key_words;
+	unsigned int	(*entry_size)(const void *entry);
+	bool		(*rule_key)(const void *entry, u32 *mask, u32 *val);
+};
+
+struct xt_rule_index_node {
+	u32	next;		/* next node in the same bucket */
+	u32	first;		/* this node's slice of ->rules */
+	u32	count;
+};
+
+struct xt_rule_index_tuple {
+	u32	mask[XT_RULE_INDEX_MAX_WORDS];
+	u32	hmask;
+	u32	*buckets;
+};
+
+struct xt_rule_index {
+	unsigned int			key_words;
+	unsigned int			ntuples;
+	unsigned int			nrules;
+	u32				*offsets;	/* rule -> entry offset */
+	u32				*rules;		/* ascending, per node */
+	u32				*keys;		/* key_words per node */
+	struct xt_rule_index_node	*nodes;
+	struct xt_rule_index_tuple	tuples[XT_RULE_INDEX_MAX_TUPLES];
+};
+
+struct xt_rule_index *
+xt_rule_index_build(const void *base, unsigned int size, unsigned int nrules,
+		    const struct xt_rule_index_ops *ops);
+u32 xt_rule_index_pos(const struct xt_rule_index *idx, unsigned int offset);
+u32 xt_rule_index_next(const struct xt_rule_index *idx, u32 pos,
+		       const u32 *key);
+
+static inline unsigned int
+xt_rule_index_offset(const struct xt_rule_index *idx, u32 rule)
+{
+	return idx->offsets[rule];
+}
+
+static inline void xt_rule_index_free(struct xt_rule_index *idx)
+{
+	kvfree(idx);
+}
+
 /**
  * xt_recseq - recursive seqcount for netfilter use
  *
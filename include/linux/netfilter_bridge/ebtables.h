@@ -84,6 +84,8 @@ struct ebt_table_info {
 	struct ebt_entries *hook_entry[NF_BR_NUMHOOKS];
 	/* room to maintain the stack used for jumping from and into udc */
 	struct ebt_chainstack **chainstack;
+	/* optional per-port rule index, see xt_rule_index_build() */
+	struct xt_rule_index *index;
 	char *entries;
 	struct ebt_counter counters[] ____cacheline_aligned;
 };
@@ -70,6 +70,8 @@ extern struct workqueue_struct *svcrdma_wq;
 
 extern struct percpu_counter svcrdma_stat_read;
 extern struct percpu_counter svcrdma_stat_recv;
+extern struct percpu_counter svcrdma_stat_rq_prod;
+extern struct percpu_counter svcrdma_stat_sq_prod;
 extern struct percpu_counter svcrdma_stat_sq_starve;
 extern struct percpu_counter svcrdma_stat_write;
 
@@ -94,6 +96,7 @@ struct svcxprt_rdma {
 
 	spinlock_t	     sc_send_lock;
 	struct llist_head    sc_send_ctxts;
+	struct llist_head    sc_send_pending;	/* Send WR chains to post */
 	spinlock_t	     sc_rw_ctxt_lock;
 	struct llist_head    sc_rw_ctxts;
 
@@ -118,6 +121,7 @@ struct svcxprt_rdma {
 };
 /* sc_flags */
 #define RDMAXPRT_CONN_PENDING	3
+#define RDMAXPRT_SQ_POSTING	4
 
 static inline struct svcxprt_rdma *svc_rdma_rqst_rdma(struct svc_rqst *rqstp)
 {
@@ -3,7 +3,10 @@
 #define _LINUX_UNICODE_H
 
 #include <linux/init.h>
+#include <linux/ctype.h>
 #include <linux/dcache.h>
+#include <linux/unaligned.h>
+#include <linux/wordpart.h>
 
 struct utf8data;
 struct utf8data_table;
@@ -72,6 +75,39 @@ int utf8_casefold(const struct unicode_map *um, const struct qstr *str,
 int utf8_casefold_hash(const struct unicode_map *um, const void *salt,
 		       struct qstr *str);
 
+/*
+ * A 7-bit ASCII name is already in NFD and has no default ignorable code
+ * points, so its NFDICF form is the name lowercased byte by byte.  Casefold
+ * lookups use this to skip the utf8 trie walk for the common case.
+ */
+static inline bool utf8_is_ascii(const unsigned char *s, size_t len)
+{
+	for (; len >= sizeof(unsigned long); len -= sizeof(unsigned long)) {
+		if (get_unaligned((const unsigned long *)s) & REPEAT_BYTE(0x80))
+			return false;
+		s += sizeof(unsigned long);
+	}
+	while (len--) {
+		if (*s++ & 0x80)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Same result as utf8_casefold_hash() for a name that passed
+ * utf8_is_ascii(), without needing a unicode_map.
+ */
+static inline void utf8_casefold_hash_ascii(const void *salt, struct qstr *str)
+{
+	unsigned long hash = init_name_hash(salt);
+	unsigned int i;
+
+	for (i = 0; i < str->len; i++)
+		hash = partial_name_hash(tolower(str->name[i]), hash);
+	str->hash = end_name_hash(hash);
+}
+
 struct unicode_map *utf8_load(unsigned int version);
 void utf8_unload(struct unicode_map *um);
 
@@ -23,6 +23,7 @@ struct kcm_psock_stats {
 	unsigned long long tx_bytes;
 	unsigned long long reserved;
 	unsigned long long unreserved;
+	unsigned long long tx_pushes;
 	unsigned int tx_aborts;
 };
 
@@ -174,6 +175,7 @@ static inline void aggregate_psock_stats(struct kcm_psock_stats *stats,
 	SAVE_PSOCK_STATS(tx_bytes);
 	SAVE_PSOCK_STATS(reserved);
 	SAVE_PSOCK_STATS(unreserved);
+	SAVE_PSOCK_STATS(tx_pushes);
 	SAVE_PSOCK_STATS(tx_aborts);
 #undef SAVE_PSOCK_STATS
 }
@@ -228,6 +228,7 @@ struct tls_context {
 	u8 rx_conf:3;
 	u8 zerocopy_sendfile:1;
 	u8 rx_no_pad:1;
+	u8 rx_parallel:1;
 	u16 tx_max_payload_len;
 
 	int (*push_pending_record)(struct sock *sk, int flags);
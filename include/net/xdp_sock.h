@@ -74,6 +74,7 @@ struct xdp_sock {
 	/* Statistics */
 	u64 rx_dropped;
 	u64 rx_queue_full;
+	u64 tx_wakeup;
 
 	/* When __xsk_generic_xmit() must return before it sees the EOP descriptor for the current
 	 * packet, the partially built skb is saved here so that packet building can resume in next
@@ -79,11 +79,18 @@ struct xsk_buff_pool {
 	u32 chunk_shift;
 	u32 frame_len;
 	u32 xdp_zc_max_segs;
+	/* Tx kicks avoided because NAPI busy polls the queue. Per pool, so
+	 * shared by all sockets bound to the same umem and queue.
+	 */
+	atomic64_t tx_wakeup_suppressed;
+	/* Tx need_wakeup left to the busy-polling NAPI thread */
+	bool tx_wakeup_deferred;
 	u8 tx_metadata_len; /* inherited from umem */
 	u8 cached_need_wakeup;
 	bool uses_need_wakeup;
 	bool unaligned;
 	bool tx_sw_csum;
+	bool zc; /* driver runs this pool in zero-copy mode */
 	void *addrs;
 	/* Mutual exclusion of the completion ring in the SKB mode.
 	 * Protect: NAPI TX thread and sendmsg error paths in the SKB
@@ -2235,6 +2235,37 @@ DECLARE_EVENT_CLASS(svcrdma_sendqueue_class,
 DEFINE_SQ_EVENT(svcrdma_sq_full);
 DEFINE_SQ_EVENT(svcrdma_sq_retry);
 
+TRACE_EVENT(svcrdma_sq_post_batch,
+	TP_PROTO(
+		const struct svcxprt_rdma *rdma,
+		const struct rpc_rdma_cid *cid,
+		unsigned int count
+	),
+
+	TP_ARGS(rdma, cid, count),
+
+	TP_STRUCT__entry(
+		__field(u32, cq_id)
+		__field(int, completion_id)
+		__field(unsigned int, count)
+		__field(int, avail)
+		__field(int, depth)
+	),
+
+	TP_fast_assign(
+		__entry->cq_id = cid->ci_queue_id;
+		__entry->completion_id = cid->ci_completion_id;
+		__entry->count = count;
+		__entry->avail = atomic_read(&rdma->sc_sq_avail);
+		__entry->depth = rdma->sc_sq_depth;
+	),
+
+	TP_printk("cq.id=%u cid=%d count=%u sc_sq_avail=%d/%d",
+		__entry->cq_id, __entry->completion_id, __entry->count,
+		__entry->avail, __entry->depth
+	)
+);
+
 TRACE_EVENT(svcrdma_sq_post_err,
 	TP_PROTO(
 		const struct svcxprt_rdma *rdma,
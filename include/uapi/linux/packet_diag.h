@@ -19,6 +19,7 @@ struct packet_diag_req {
 #define PACKET_SHOW_FANOUT	0x00000008
 #define PACKET_SHOW_MEMINFO	0x00000010
 #define PACKET_SHOW_FILTER	0x00000020
+#define PACKET_SHOW_STATS	0x00000040
 
 struct packet_diag_msg {
 	__u8	pdiag_family;
@@ -39,6 +40,7 @@ enum {
 	PACKET_DIAG_UID,
 	PACKET_DIAG_MEMINFO,
 	PACKET_DIAG_FILTER,
+	PACKET_DIAG_STATS,
 
 	__PACKET_DIAG_MAX,
 };
@@ -68,6 +70,19 @@ struct packet_diag_mclist {
 	__u8	pdmc_addr[32]; /* MAX_ADDR_LEN */
 };
 
+/* Counters since the last PACKET_STATISTICS read, reading them here does
+ * not reset them.
+ */
+struct packet_diag_stats {
+	__u32	pds_packets;
+	__u32	pds_drops;
+	__u32	pds_freeze_q_cnt;
+	__u32	pds_pad;
+	__u64	pds_rollover;		/* fanout rollover statistics */
+	__u64	pds_rollover_huge;
+	__u64	pds_rollover_failed;
+};
+
 struct packet_diag_ring {
 	__u32	pdr_block_size;
 	__u32	pdr_block_nr;
@@ -369,6 +369,8 @@ enum
 	LINUX_MIB_TLSTXREKEYOK,			/* TlsTxRekeyOk */
 	LINUX_MIB_TLSTXREKEYERROR,		/* TlsTxRekeyError */
 	LINUX_MIB_TLSRXREKEYRECEIVED,		/* TlsRxRekeyReceived */
+	LINUX_MIB_TLSRXPARALLEL,		/* TlsRxParallel */
+	LINUX_MIB_TLSRXDECRYPTASYNC,		/* TlsRxDecryptAsync */
 	__LINUX_MIB_TLSMAX
 };
 
@@ -78,6 +78,10 @@ struct xdp_diag_stats {
 	__u64	n_fill_ring_empty;
 	__u64	n_tx_invalid;
 	__u64	n_tx_ring_empty;
+	__u64	n_tx_wakeup;		/* Tx kicks passed to the driver */
+	__u64	n_tx_wakeup_suppressed;	/* Tx kicks avoided by busy polling,
+					 * per umem pool, not per socket
+					 */
 };
 
 #endif /* _LINUX_XDP_DIAG_H */
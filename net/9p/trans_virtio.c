@@ -52,6 +52,7 @@ static atomic_t vp_pinned = ATOMIC_INIT(0);
  * @ring_bufs_avail: flag to indicate there is some available in the ring buf
  * @vc_wq: wait queue for waiting for thing to be added to ring buf
  * @p9_max_pages: maximum number of pinned pages
+ * @max_seg_size: largest segment the device can DMA in one descriptor
  * @sg: scatter gather list which is used to pack a request (protected?)
  * @chan_list: linked list of channels
  *
@@ -75,6 +76,7 @@ struct virtio_chan {
 	 * will be placing it in each channel.
 	 */
 	unsigned long p9_max_pages;
+	unsigned int max_seg_size;
 	/* Scatterlist: can be too big for stack. */
 	struct scatterlist sg[VIRTQUEUE_NUM];
 	/**
@@ -153,11 +155,46 @@ static void req_done(struct virtqueue *vq)
 		wake_up(chan->vc_wq);
 }
 
+/**
+ * sg_merge_last - extend the last packed segment if @page continues it
+ * @sg: scatter/gather list being packed
+ * @start: first segment packed by the current caller
+ * @index: next free segment
+ * @max_seg: maximum length of a packed segment
+ * @page: page holding the data to pack
+ * @offs: offset of the data within @page
+ * @len: amount of data to pack
+ *
+ * Physically contiguous runs (kmalloc'ed buffers, large folios pinned from
+ * user space) then take one descriptor instead of one per page, leaving
+ * room in the ring for more requests in flight. A segment never grows past
+ * @max_seg, so the transport can still map it in one go.
+ */
+static bool sg_merge_last(struct scatterlist *sg, int start, int index,
+			  unsigned int max_seg, struct page *page,
+			  unsigned int offs, int len)
+{
+	struct scatterlist *last;
+
+	if (index == start)
+		return false;
+
+	last = &sg[index - 1];
+	if (len > max_seg - last->length)
+		return false;
+	if (sg_phys(last) + last->length != page_to_phys(page) + offs)
+		return false;
+
+	last->length += len;
+	return true;
+}
+
 /**
  * pack_sg_list - pack a scatter gather list from a linear buffer
  * @sg: scatter/gather list to pack into
  * @start: which segment of the sg_list to start at
  * @limit: maximum segment to pack data to
+ * @max_seg: maximum length of a packed segment
  * @data: data to pack into scatter/gather list
  * @count: amount of data to pack into the scatter/gather list
  *
@@ -167,8 +204,8 @@ static void req_done(struct virtqueue *vq)
  *
  */
 
-static int pack_sg_list(struct scatterlist *sg, int start,
-			int limit, char *data, int count)
+static int pack_sg_list(struct scatterlist *sg, int start, int limit,
+			unsigned int max_seg, char *data, int count)
 {
 	int s;
 	int index = start;
@@ -177,10 +214,13 @@ static int pack_sg_list(struct scatterlist *sg, int start,
 		s = rest_of_page(data);
 		if (s > count)
 			s = count;
-		BUG_ON(index >= limit);
-		/* Make sure we don't terminate early. */
-		sg_unmark_end(&sg[index]);
-		sg_set_buf(&sg[index++], data, s);
+		if (!sg_merge_last(sg, start, index, max_seg,
+				   virt_to_page(data), offset_in_page(data), s)) {
+			BUG_ON(index >= limit);
+			/* Make sure we don't terminate early. */
+			sg_unmark_end(&sg[index]);
+			sg_set_buf(&sg[index++], data, s);
+		}
 		count -= s;
 		data += s;
 	}
@@ -208,6 +248,7 @@ static int p9_virtio_cancelled(struct p9_client *client, struct p9_req_t *req)
  * @sg: scatter/gather list to pack into
  * @start: which segment of the sg_list to start at
  * @limit: maximum number of pages in sg list.
+ * @max_seg: maximum length of a packed segment
  * @pdata: a list of pages to add into sg.
  * @nr_pages: number of pages to pack into the scatter/gather list
  * @offs: amount of data in the beginning of first page _not_ to pack
@@ -215,7 +256,8 @@ static int p9_virtio_cancelled(struct p9_client *client, struct p9_req_t *req)
  */
 static int
 pack_sg_list_p(struct scatterlist *sg, int start, int limit,
-	       struct page **pdata, int nr_pages, size_t offs, int count)
+	       unsigned int max_seg, struct page **pdata, int nr_pages,
+	       size_t offs, int count)
 {
 	int i = 0, s;
 	int data_off = offs;
@@ -230,10 +272,14 @@ pack_sg_list_p(struct scatterlist *sg, int start, int limit,
 		s = PAGE_SIZE - data_off;
 		if (s > count)
 			s = count;
-		BUG_ON(index >= limit);
-		/* Make sure we don't terminate early. */
-		sg_unmark_end(&sg[index]);
-		sg_set_page(&sg[index++], pdata[i++], s, data_off);
+		if (!sg_merge_last(sg, start, index, max_seg, pdata[i],
+				   data_off, s)) {
+			BUG_ON(index >= limit);
+			/* Make sure we don't terminate early. */
+			sg_unmark_end(&sg[index]);
+			sg_set_page(&sg[index++], pdata[i], s, data_off);
+		}
+		i++;
 		data_off = 0;
 		count -= s;
 		nr_pages--;
@@ -268,13 +314,13 @@ p9_virtio_request(struct p9_client *client, struct p9_req_t *req)
 
 	out_sgs = in_sgs = 0;
 	/* Handle out VirtIO ring buffers */
-	out = pack_sg_list(chan->sg, 0,
-			   VIRTQUEUE_NUM, req->tc.sdata, req->tc.size);
+	out = pack_sg_list(chan->sg, 0, VIRTQUEUE_NUM, chan->max_seg_size,
+			   req->tc.sdata, req->tc.size);
 	if (out)
 		sgs[out_sgs++] = chan->sg;
 
-	in = pack_sg_list(chan->sg, out,
-			  VIRTQUEUE_NUM, req->rc.sdata, req->rc.capacity);
+	in = pack_sg_list(chan->sg, out, VIRTQUEUE_NUM, chan->max_seg_size,
+			  req->rc.sdata, req->rc.capacity);
 	if (in)
 		sgs[out_sgs + in_sgs++] = chan->sg + out;
 
@@ -475,8 +521,8 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	out_sgs = in_sgs = 0;
 
 	/* out data */
-	out = pack_sg_list(chan->sg, 0,
-			   VIRTQUEUE_NUM, req->tc.sdata, req->tc.size);
+	out = pack_sg_list(chan->sg, 0, VIRTQUEUE_NUM, chan->max_seg_size,
+			   req->tc.sdata, req->tc.size);
 
 	if (out)
 		sgs[out_sgs++] = chan->sg;
@@ -484,7 +530,8 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	if (out_pages) {
 		sgs[out_sgs++] = chan->sg + out;
 		out += pack_sg_list_p(chan->sg, out, VIRTQUEUE_NUM,
-				      out_pages, out_nr_pages, offs, outlen);
+				      chan->max_seg_size, out_pages,
+				      out_nr_pages, offs, outlen);
 	}
 
 	/*
@@ -494,15 +541,16 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	 * Arrange in such a way that server places header in the
 	 * allocated memory and payload onto the user buffer.
 	 */
-	in = pack_sg_list(chan->sg, out,
-			  VIRTQUEUE_NUM, req->rc.sdata, in_hdr_len);
+	in = pack_sg_list(chan->sg, out, VIRTQUEUE_NUM, chan->max_seg_size,
+			  req->rc.sdata, in_hdr_len);
 	if (in)
 		sgs[out_sgs + in_sgs++] = chan->sg + out;
 
 	if (in_pages) {
 		sgs[out_sgs + in_sgs++] = chan->sg + out + in;
 		pack_sg_list_p(chan->sg, out + in, VIRTQUEUE_NUM,
-			       in_pages, in_nr_pages, offs, inlen);
+			       chan->max_seg_size, in_pages,
+			       in_nr_pages, offs, inlen);
 	}
 
 	BUG_ON(out_sgs + in_sgs > ARRAY_SIZE(sgs));
@@ -610,6 +658,8 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 	}
 
 	chan->vdev = vdev;
+	chan->max_seg_size = min_t(size_t, virtio_max_dma_size(vdev),
+				   UINT_MAX);
 
 	/* We expect one virtqueue, for requests. */
 	chan->vq = virtio_find_single_vq(vdev, req_done, "requests");
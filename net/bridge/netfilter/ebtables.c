@@ -182,6 +182,98 @@ struct ebt_entry *ebt_next_entry(const struct ebt_entry *entry)
 	return (void *)entry + entry->next_offset;
 }
 
+/* Per-port rule dispatch, see xt_rule_index_build().
+ *
+ * Large bridge rulesets are mostly rules for one ingress port and/or one
+ * MAC address.  A rule's selector is its exact input interface, source MAC
+ * and destination MAC, so a frame steps from one candidate rule to the
+ * next one that can match its ingress port and addresses instead of
+ * walking every rule of the chain.  Wildcard interface names, masked and
+ * inverted selectors are indexed as "any".
+ */
+struct ebt_idx_key {
+	char	in[IFNAMSIZ];
+	u8	src[ETH_ALEN];
+	u8	dst[ETH_ALEN];
+} __aligned(4);
+
+static unsigned int ebt_idx_entry_size(const void *entry)
+{
+	const struct ebt_entry *e = entry;
+
+	return e->bitmask ? e->next_offset : sizeof(struct ebt_entries);
+}
+
+static void ebt_idx_fill_key(struct ebt_idx_key *key, const char *in,
+			     const u8 *src, const u8 *dst)
+{
+	if (in)
+		strscpy_pad(key->in, in, IFNAMSIZ);
+	else
+		memset(key->in, 0, IFNAMSIZ);
+	ether_addr_copy(key->src, src);
+	ether_addr_copy(key->dst, dst);
+}
+
+static bool ebt_idx_rule_key(const void *entry, u32 *mask, u32 *val)
+{
+	struct ebt_idx_key *m = (struct ebt_idx_key *)mask;
+	const struct ebt_entry *e = entry;
+
+	/* chain headers have no bitmask */
+	if (!e->bitmask)
+		return false;
+
+	memset(m, 0, sizeof(*m));
+	if (e->in[0] && !(e->invflags & EBT_IIN) &&
+	    strnlen(e->in, IFNAMSIZ) < IFNAMSIZ && !strchr(e->in, 1))
+		memset(m->in, 0xff, IFNAMSIZ);
+	if ((e->bitmask & EBT_SOURCEMAC) && !(e->invflags & EBT_ISOURCE) &&
+	    is_broadcast_ether_addr(e->sourcemsk))
+		eth_broadcast_addr(m->src);
+	if ((e->bitmask & EBT_DESTMAC) && !(e->invflags & EBT_IDEST) &&
+	    is_broadcast_ether_addr(e->destmsk))
+		eth_broadcast_addr(m->dst);
+
+	ebt_idx_fill_key((struct ebt_idx_key *)val,
+			 strnlen(e->in, IFNAMSIZ) < IFNAMSIZ ? e->in : NULL,
+			 e->sourcemac, e->destmac);
+	return true;
+}
+
+static const struct xt_rule_index_ops ebt_idx_ops = {
+	.key_words	= sizeof(struct ebt_idx_key) / sizeof(u32),
+	.entry_size	= ebt_idx_entry_size,
+	.rule_key	= ebt_idx_rule_key,
+};
+
+/* Advance from @point, the @i'th rule of a chain of @nentries, to the next
+ * rule of the chain that can match the frame.  Sets @i to @nentries if
+ * there is none.  The key is rebuilt on every step, as a target returning
+ * EBT_CONTINUE may have rewritten the header.
+ */
+static struct ebt_entry *
+ebt_idx_next(const struct xt_rule_index *idx, const char *base,
+	     const struct ebt_entry *point, int *i, int nentries,
+	     const struct sk_buff *skb, const struct net_device *in)
+{
+	const struct ethhdr *h = eth_hdr(skb);
+	struct ebt_idx_key key;
+	u32 pos, best;
+
+	ebt_idx_fill_key(&key, in ? in->name : NULL, h->h_source, h->h_dest);
+	pos = xt_rule_index_pos(idx, (const char *)point - base);
+	best = xt_rule_index_next(idx, pos, (const u32 *)&key);
+
+	/* XT_RULE_INDEX_NONE is past the end of any chain as well */
+	if (best >= pos - *i + nentries) {
+		*i = nentries;
+		return (struct ebt_entry *)point;
+	}
+	*i += best - pos;
+	return (struct ebt_entry *)(base + xt_rule_index_offset(idx, best));
+}
+
 static inline const struct ebt_entry_target *
 ebt_get_target_c(const struct ebt_entry *e)
 {
@@ -203,6 +295,7 @@ unsigned int ebt_do_table(void *priv, struct sk_buff *skb,
 	struct ebt_entries *chaininfo;
 	const char *base;
 	const struct ebt_table_info *private;
+	const struct xt_rule_index *idx;
 	struct xt_action_param acpar;
 
 	acpar.state   = state;
@@ -222,6 +315,7 @@ unsigned int ebt_do_table(void *priv, struct sk_buff *skb,
 	counter_base = cb_base + private->hook_entry[hook]->counter_offset;
 	/* base for chain jumps */
 	base = private->entries;
+	idx = private->index;
 	i = 0;
 	while (i < nentries) {
 		if (ebt_basic_match(point, skb, state->in, state->out))
@@ -301,6 +395,11 @@ unsigned int ebt_do_table(void *priv, struct sk_buff *skb,
 		sp++;
 		continue;
 letscontinue:
+		if (idx) {
+			point = ebt_idx_next(idx, base, point, &i, nentries,
+					     skb, state->in);
+			continue;
+		}
 		point = ebt_next_entry(point);
 		i++;
 	}
@@ -383,6 +482,9 @@ static inline void ebt_free_table_info(struct ebt_table_info *info)
 {
 	int i;
 
+	xt_rule_index_free(info->index);
+	info->index = NULL;
+
 	if (info->chainstack) {
 		for_each_possible_cpu(i)
 			vfree(info->chainstack[i]);
@@ -978,6 +1080,11 @@ static int translate_table(struct net *net, const char *name,
 	if (ret != 0) {
 		EBT_ENTRY_ITERATE(newinfo->entries, newinfo->entries_size,
 				  ebt_cleanup_entry, net, &i);
+	} else {
+		newinfo->index = xt_rule_index_build(newinfo->entries,
+						     newinfo->entries_size,
+						     newinfo->nentries,
+						     &ebt_idx_ops);
 	}
 	vfree(cl_s);
 	return ret;
@@ -1025,6 +1132,7 @@ static int do_replace_finish(struct net *net, struct ebt_replace *repl,
 	}
 
 	newinfo->chainstack = NULL;
+	newinfo->index = NULL;
 	ret = ebt_verify_pointers(repl, newinfo);
 	if (ret != 0)
 		goto free_counterstmp;
@@ -1223,6 +1331,7 @@ int ebt_register_table(struct net *net, const struct ebt_table *input_table,
 
 	/* fill in newinfo and parse the entries */
 	newinfo->chainstack = NULL;
+	newinfo->index = NULL;
 	for (i = 0; i < NF_BR_NUMHOOKS; i++) {
 		if ((repl->valid_hooks & (1 << i)) == 0)
 			newinfo->hook_entry[i] = NULL;
@@ -406,6 +406,13 @@ static struct hlist_head *can_rcv_list_find(canid_t *can_id, canid_t *mask,
 		}
 	}
 
+	/* can_id/can_mask filters that fix the low can_id bits (e.g. one
+	 * filter per can_id without the EFF/RTR flags in the mask) are
+	 * spread over rx_fil[] by those bits
+	 */
+	if ((*mask & CAN_FIL_RCV_HASH_MASK) == CAN_FIL_RCV_HASH_MASK)
+		return &dev_rcv_lists->rx_fil[*can_id & CAN_FIL_RCV_HASH_MASK];
+
 	/* default: filter via can_id/can_mask */
 	return &dev_rcv_lists->rx[RX_FIL];
 }
@@ -611,6 +618,13 @@ static int can_rcv_filter(struct can_dev_rcv_lists *dev_rcv_lists, struct sk_buf
 		}
 	}
 
+	hlist_for_each_entry_rcu(rcv, &dev_rcv_lists->rx_fil[can_id & CAN_FIL_RCV_HASH_MASK], list) {
+		if ((can_id & rcv->mask) == rcv->can_id) {
+			deliver(skb, rcv);
+			matches++;
+		}
+	}
+
 	/* check for inverted can_id/mask entries */
 	hlist_for_each_entry_rcu(rcv, &dev_rcv_lists->rx[RX_INV], list) {
 		if ((can_id & rcv->mask) != rcv->can_id) {
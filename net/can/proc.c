@@ -302,9 +302,19 @@ static inline void can_rcvlist_proc_show_one(struct seq_file *m, int idx,
 					     struct net_device *dev,
 					     struct can_dev_rcv_lists *dev_rcv_lists)
 {
-	if (!hlist_empty(&dev_rcv_lists->rx[idx])) {
+	/* RX_FIL entries are also spread over the rx_fil hash buckets */
+	unsigned int nfil = idx == RX_FIL ? ARRAY_SIZE(dev_rcv_lists->rx_fil) : 0;
+	int empty = hlist_empty(&dev_rcv_lists->rx[idx]);
+	unsigned int i;
+
+	for (i = 0; empty && i < nfil; i++)
+		empty = hlist_empty(&dev_rcv_lists->rx_fil[i]);
+
+	if (!empty) {
 		can_print_recv_banner(m);
 		can_print_rcvlist(m, &dev_rcv_lists->rx[idx], dev);
+		for (i = 0; i < nfil; i++)
+			can_print_rcvlist(m, &dev_rcv_lists->rx_fil[i], dev);
 	} else
 		seq_printf(m, "  (%s: no entry)\n", DNAME(dev));
 
@@ -142,7 +142,7 @@ static bool is_proxy_supervision_frame(struct hsr_priv *hsr,
 	/* For RedBox (HSR-SAN) check if we have received the supervision
 	 * frame with MAC addresses from own ProxyNodeTable.
 	 */
-	return hsr_is_node_in_db(&hsr->proxy_node_db,
+	return hsr_is_node_in_db(hsr, &hsr->proxy_node_db,
 				 payload->macaddress_A);
 }
 
@@ -468,7 +468,7 @@ bool hsr_drop_frame(struct hsr_frame_info *frame, struct hsr_port *port)
 	skb = frame->skb_hsr;
 	if (skb && prp_drop_frame(frame, port) &&
 	    is_unicast_ether_addr(eth_hdr(skb)->h_dest) &&
-	    hsr_is_node_in_db(&port->hsr->proxy_node_db,
+	    hsr_is_node_in_db(port->hsr, &port->hsr->proxy_node_db,
 			      eth_hdr(skb)->h_dest)) {
 		return true;
 	}
@@ -481,7 +481,7 @@ bool hsr_drop_frame(struct hsr_frame_info *frame, struct hsr_port *port)
 	    port->type == HSR_PT_INTERLINK) {
 		skb = frame->skb_hsr;
 		if (skb && is_unicast_ether_addr(eth_hdr(skb)->h_dest) &&
-		    hsr_is_node_in_db(&port->hsr->node_db,
+		    hsr_is_node_in_db(port->hsr, &port->hsr->node_db,
 				      eth_hdr(skb)->h_dest)) {
 			return true;
 		}
@@ -495,7 +495,7 @@ bool hsr_drop_frame(struct hsr_frame_info *frame, struct hsr_port *port)
 	    frame->port_rcv->type == HSR_PT_INTERLINK) {
 		skb = frame->skb_std;
 		if (skb && is_unicast_ether_addr(eth_hdr(skb)->h_dest) &&
-		    hsr_is_node_in_db(&port->hsr->proxy_node_db,
+		    hsr_is_node_in_db(port->hsr, &port->hsr->proxy_node_db,
 				      eth_hdr(skb)->h_dest)) {
 			return true;
 		}
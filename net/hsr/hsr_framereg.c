@@ -13,6 +13,7 @@
 
 #include <linux/if_ether.h>
 #include <linux/etherdevice.h>
+#include <linux/jhash.h>
 #include <linux/slab.h>
 #include <linux/rculist.h>
 #include "hsr_main.h"
@@ -65,15 +66,43 @@ bool hsr_addr_is_self(struct hsr_priv *hsr, unsigned char *addr)
 	return ret;
 }
 
-/* Search for mac entry. Caller must hold rcu read lock.
+/* The addresses come from the wire, so keep their buckets unpredictable */
+static u32 hsr_addr_hash(struct hsr_priv *hsr,
+			 const unsigned char addr[ETH_ALEN])
+{
+	return jhash(addr, ETH_ALEN, hsr->node_hash_seed);
+}
+
+/* Search for mac entry. Caller must hold rcu read lock or list_lock.
  */
-static struct hsr_node *find_node_by_addr_A(struct list_head *node_db,
+static struct hsr_node *find_node_by_addr_A(struct hsr_priv *hsr,
+					    struct list_head *node_db,
+					    const unsigned char addr[ETH_ALEN])
+{
+	struct hsr_node *node;
+
+	hash_for_each_possible_rcu(hsr->node_hash_A, node, addr_A_hash,
+				   hsr_addr_hash(hsr, addr),
+				   lockdep_is_held(&hsr->list_lock)) {
+		if (node->node_db == node_db &&
+		    ether_addr_equal(node->macaddress_A, addr))
+			return node;
+	}
+
+	return NULL;
+}
+
+static struct hsr_node *find_node_by_addr_B(struct hsr_priv *hsr,
+					    struct list_head *node_db,
 					    const unsigned char addr[ETH_ALEN])
 {
 	struct hsr_node *node;
 
-	list_for_each_entry_rcu(node, node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, addr))
+	hash_for_each_possible_rcu(hsr->node_hash_B, node, addr_B_hash,
+				   hsr_addr_hash(hsr, addr),
+				   lockdep_is_held(&hsr->list_lock)) {
+		if (node->node_db == node_db &&
+		    ether_addr_equal(node->macaddress_B, addr))
 			return node;
 	}
 
@@ -82,10 +111,26 @@ static struct hsr_node *find_node_by_addr_A(struct list_head *node_db,
 
 /* Check if node for a given MAC address is already present in data base
  */
-bool hsr_is_node_in_db(struct list_head *node_db,
+bool hsr_is_node_in_db(struct hsr_priv *hsr, struct list_head *node_db,
 		       const unsigned char addr[ETH_ALEN])
 {
-	return !!find_node_by_addr_A(node_db, addr);
+	return !!find_node_by_addr_A(hsr, node_db, addr);
+}
+
+/* Take a node out of its table and the address hashes. Caller must hold
+ * list_lock.
+ */
+static void hsr_unlink_node(struct hsr_node *node)
+{
+	if (node->removed)
+		return;
+
+	list_del_rcu(&node->mac_list);
+	hash_del_rcu(&node->addr_A_hash);
+	hash_del_rcu(&node->addr_B_hash);
+	node->removed = true;
+	/* Note that we need to free this entry later: */
+	kfree_rcu(node, rcu_head);
 }
 
 /* Helper for device init; the self_node is used in hsr_rcv() to recognize
@@ -167,6 +212,7 @@ static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
 		return NULL;
 
 	ether_addr_copy(new_node->macaddress_A, addr);
+	new_node->addr_B_hash_gp = get_completed_synchronize_rcu();
 	spin_lock_init(&new_node->seq_out_lock);
 
 	/* We are only interested in time diffs here, so use current jiffies
@@ -187,14 +233,15 @@ static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
 		hsr->proto_ops->handle_san_frame(san, rx_port, new_node);
 
 	spin_lock_bh(&hsr->list_lock);
-	list_for_each_entry_rcu(node, node_db, mac_list,
-				lockdep_is_held(&hsr->list_lock)) {
-		if (ether_addr_equal(node->macaddress_A, addr))
-			goto out;
-		if (ether_addr_equal(node->macaddress_B, addr))
-			goto out;
-	}
+	node = find_node_by_addr_A(hsr, node_db, addr);
+	if (!node)
+		node = find_node_by_addr_B(hsr, node_db, addr);
+	if (node)
+		goto out;
+	new_node->node_db = node_db;
 	list_add_tail_rcu(&new_node->mac_list, node_db);
+	hash_add_rcu(hsr->node_hash_A, &new_node->addr_A_hash,
+		     hsr_addr_hash(hsr, addr));
 	spin_unlock_bh(&hsr->list_lock);
 	return new_node;
 out:
@@ -230,26 +277,17 @@ struct hsr_node *hsr_get_node(struct hsr_port *port, struct list_head *node_db,
 
 	ethhdr = (struct ethhdr *)skb_mac_header(skb);
 
-	list_for_each_entry_rcu(node, node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, ethhdr->h_source)) {
-			if (hsr->proto_ops->update_san_info)
-				hsr->proto_ops->update_san_info(node, is_sup);
-			return node;
-		}
-		if (ether_addr_equal(node->macaddress_B, ethhdr->h_source)) {
-			if (hsr->proto_ops->update_san_info)
-				hsr->proto_ops->update_san_info(node, is_sup);
-			return node;
-		}
-	}
-
+	node = find_node_by_addr_A(hsr, node_db, ethhdr->h_source);
+	if (!node)
+		node = find_node_by_addr_B(hsr, node_db, ethhdr->h_source);
 	/* Check if required node is not in proxy nodes table */
-	list_for_each_entry_rcu(node, &hsr->proxy_node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, ethhdr->h_source)) {
-			if (hsr->proto_ops->update_san_info)
-				hsr->proto_ops->update_san_info(node, is_sup);
-			return node;
-		}
+	if (!node)
+		node = find_node_by_addr_A(hsr, &hsr->proxy_node_db,
+					   ethhdr->h_source);
+	if (node) {
+		if (hsr->proto_ops->update_san_info)
+			hsr->proto_ops->update_san_info(node, is_sup);
+		return node;
 	}
 
 	/* Everyone may create a node entry, connected node to a HSR/PRP
@@ -336,7 +374,7 @@ void hsr_handle_sup_frame(struct hsr_frame_info *frame)
 
 	/* Merge node_curr (registered on macaddress_B) into node_real */
 	node_db = &port_rcv->hsr->node_db;
-	node_real = find_node_by_addr_A(node_db, hsr_sp->macaddress_A);
+	node_real = find_node_by_addr_A(hsr, node_db, hsr_sp->macaddress_A);
 	if (!node_real)
 		/* No frame received from AddrA of this node yet */
 		node_real = hsr_add_node(hsr, node_db, hsr_sp->macaddress_A,
@@ -379,7 +417,6 @@ void hsr_handle_sup_frame(struct hsr_frame_info *frame)
 		}
 	}
 
-	ether_addr_copy(node_real->macaddress_B, ethhdr->h_source);
 	spin_lock_bh(&node_real->seq_out_lock);
 	for (i = 0; i < HSR_PT_PORTS; i++) {
 		if (!node_curr->time_in_stale[i] &&
@@ -395,11 +432,24 @@ void hsr_handle_sup_frame(struct hsr_frame_info *frame)
 	node_real->addr_B_port = port_rcv->type;
 
 	spin_lock_bh(&hsr->list_lock);
-	if (!node_curr->removed) {
-		list_del_rcu(&node_curr->mac_list);
-		node_curr->removed = true;
-		kfree_rcu(node_curr, rcu_head);
+	if (!node_real->removed &&
+	    !ether_addr_equal(node_real->macaddress_B, ethhdr->h_source)) {
+		/* Readers may still be walking the old bucket through this
+		 * node, so it can't join another chain right away.
+		 */
+		if (!hlist_unhashed(&node_real->addr_B_hash)) {
+			hash_del_rcu(&node_real->addr_B_hash);
+			node_real->addr_B_hash_gp = get_state_synchronize_rcu();
+		}
+		ether_addr_copy(node_real->macaddress_B, ethhdr->h_source);
 	}
+	/* Otherwise a later supervision frame hashes it */
+	if (!node_real->removed &&
+	    hlist_unhashed(&node_real->addr_B_hash) &&
+	    poll_state_synchronize_rcu(node_real->addr_B_hash_gp))
+		hash_add_rcu(hsr->node_hash_B, &node_real->addr_B_hash,
+			     hsr_addr_hash(hsr, node_real->macaddress_B));
+	hsr_unlink_node(node_curr);
 	spin_unlock_bh(&hsr->list_lock);
 
 done:
@@ -445,10 +495,11 @@ void hsr_addr_subst_dest(struct hsr_node *node_src, struct sk_buff *skb,
 	if (!is_unicast_ether_addr(eth_hdr(skb)->h_dest))
 		return;
 
-	node_dst = find_node_by_addr_A(&port->hsr->node_db,
+	node_dst = find_node_by_addr_A(port->hsr, &port->hsr->node_db,
 				       eth_hdr(skb)->h_dest);
 	if (!node_dst && port->hsr->redbox)
-		node_dst = find_node_by_addr_A(&port->hsr->proxy_node_db,
+		node_dst = find_node_by_addr_A(port->hsr,
+					       &port->hsr->proxy_node_db,
 					       eth_hdr(skb)->h_dest);
 
 	if (!node_dst) {
@@ -668,12 +719,7 @@ void hsr_prune_nodes(struct timer_list *t)
 		if (time_is_before_jiffies(timestamp +
 				msecs_to_jiffies(HSR_NODE_FORGET_TIME))) {
 			hsr_nl_nodedown(hsr, node->macaddress_A);
-			if (!node->removed) {
-				list_del_rcu(&node->mac_list);
-				node->removed = true;
-				/* Note that we need to free this entry later: */
-				kfree_rcu(node, rcu_head);
-			}
+			hsr_unlink_node(node);
 		}
 	}
 	spin_unlock_bh(&hsr->list_lock);
@@ -702,12 +748,7 @@ void hsr_prune_proxy_nodes(struct timer_list *t)
 		if (time_is_before_jiffies(timestamp +
 				msecs_to_jiffies(HSR_PROXY_NODE_FORGET_TIME))) {
 			hsr_nl_nodedown(hsr, node->macaddress_A);
-			if (!node->removed) {
-				list_del_rcu(&node->mac_list);
-				node->removed = true;
-				/* Note that we need to free this entry later: */
-				kfree_rcu(node, rcu_head);
-			}
+			hsr_unlink_node(node);
 		}
 	}
 
@@ -753,7 +794,7 @@ int hsr_get_node_data(struct hsr_priv *hsr,
 	struct hsr_port *port;
 	unsigned long tdiff;
 
-	node = find_node_by_addr_A(&hsr->node_db, addr);
+	node = find_node_by_addr_A(hsr, &hsr->node_db, addr);
 	if (!node)
 		return -ENOENT;
 
@@ -69,13 +69,19 @@ void prp_handle_san_frame(bool san, enum hsr_port_type port,
 			  struct hsr_node *node);
 void prp_update_san_info(struct hsr_node *node, bool is_sup);
 
-bool hsr_is_node_in_db(struct list_head *node_db,
+bool hsr_is_node_in_db(struct hsr_priv *hsr, struct list_head *node_db,
 		       const unsigned char addr[ETH_ALEN]);
 
 int prp_register_frame_out(struct hsr_port *port, struct hsr_frame_info *frame);
 
 struct hsr_node {
 	struct list_head	mac_list;
+	/* node_db or proxy_node_db, whichever holds this node */
+	struct list_head	*node_db;
+	struct hlist_node	addr_A_hash;
+	struct hlist_node	addr_B_hash;	/* unhashed until AddrB known */
+	/* RCU grace period to wait for before addr_B_hash is reused */
+	unsigned long		addr_B_hash_gp;
 	/* Protect R/W access to seq_out */
 	spinlock_t		seq_out_lock;
 	unsigned char		macaddress_A[ETH_ALEN];
@@ -12,6 +12,7 @@
 
 #include <linux/netdevice.h>
 #include <linux/list.h>
+#include <linux/hashtable.h>
 #include <linux/if_vlan.h>
 #include <linux/if_hsr.h>
 
@@ -186,11 +187,17 @@ struct hsr_self_node {
 	struct rcu_head	rcu_head;
 };
 
+#define HSR_NODE_HASH_BITS	8
+
 struct hsr_priv {
 	struct rcu_head		rcu_head;
 	struct list_head	ports;
 	struct list_head	node_db;	/* Known HSR nodes */
 	struct list_head	proxy_node_db;	/* RedBox HSR proxy nodes */
+	/* Nodes of both tables indexed by macaddress_A / macaddress_B */
+	DECLARE_HASHTABLE(node_hash_A, HSR_NODE_HASH_BITS);
+	DECLARE_HASHTABLE(node_hash_B, HSR_NODE_HASH_BITS);
+	u32			node_hash_seed;
 	struct hsr_self_node	__rcu *self_node;	/* MACs of slaves */
 	struct timer_list	announce_timer;	/* Supervision frame dispatch */
 	struct timer_list	announce_proxy_timer;
@@ -218,6 +218,71 @@ struct ipt_entry *ipt_next_entry(const struct ipt_entry *entry)
 	return (void *)entry + entry->next_offset;
 }
 
+/* Rule lookup acceleration for large tables, see xt_rule_index_build().
+ *
+ * A rule's selector is its (source, destination, protocol) part.  Inverted
+ * selectors are indexed as wildcards.  Chains end in an unconditional
+ * rule, which every packet hits, so a search never runs past the end of
+ * the chain it started in.
+ */
+struct ipt_idx_key {
+	__be32	src;
+	__be32	dst;
+	u32	proto;
+};
+
+static unsigned int ipt_idx_entry_size(const void *entry)
+{
+	return ((const struct ipt_entry *)entry)->next_offset;
+}
+
+static bool ipt_idx_rule_key(const void *entry, u32 *mask, u32 *val)
+{
+	const struct ipt_ip *ip = &((const struct ipt_entry *)entry)->ip;
+	struct ipt_idx_key *m = (struct ipt_idx_key *)mask;
+	struct ipt_idx_key *v = (struct ipt_idx_key *)val;
+
+	m->src = ip->invflags & IPT_INV_SRCIP ? 0 : ip->smsk.s_addr;
+	m->dst = ip->invflags & IPT_INV_DSTIP ? 0 : ip->dmsk.s_addr;
+	m->proto = ip->proto && !(ip->invflags & IPT_INV_PROTO) ? ~0U : 0;
+	v->src = ip->src.s_addr;
+	v->dst = ip->dst.s_addr;
+	v->proto = ip->proto;
+	return true;
+}
+
+static const struct xt_rule_index_ops ipt_idx_ops = {
+	.key_words	= sizeof(struct ipt_idx_key) / sizeof(u32),
+	.entry_size	= ipt_idx_entry_size,
+	.rule_key	= ipt_idx_rule_key,
+};
+
+/* Performance critical */
+static struct ipt_entry *
+ipt_idx_next(const struct xt_rule_index *idx, const void *table_base,
+	     const struct ipt_entry *e, const struct iphdr *ip)
+{
+	const struct ipt_idx_key key = {
+		.src	= ip->saddr,
+		.dst	= ip->daddr,
+		.proto	= ip->protocol,
+	};
+	u32 next;
+
+	next = xt_rule_index_next(idx,
+				  xt_rule_index_pos(idx, (void *)e - table_base),
+				  (const u32 *)&key);
+	if (next == XT_RULE_INDEX_NONE)
+		return ipt_next_entry(e);
+	return get_entry(table_base, xt_rule_index_offset(idx, next));
+}
+
+static void ipt_free_table_info(struct xt_table_info *info)
+{
+	xt_rule_index_free(info->rule_index);
+	xt_free_table_info(info);
+}
+
 /* Returns one of the generic firewall policies, like NF_ACCEPT. */
 unsigned int
 ipt_do_table(void *priv,
@@ -235,6 +300,7 @@ ipt_do_table(void *priv,
 	struct ipt_entry *e, **jumpstack;
 	unsigned int stackidx, cpu;
 	const struct xt_table_info *private;
+	const struct xt_rule_index *idx;
 	struct xt_action_param acpar;
 	unsigned int addend;
 
@@ -261,6 +327,7 @@ ipt_do_table(void *priv,
 	cpu        = smp_processor_id();
 	table_base = private->entries;
 	jumpstack  = (struct ipt_entry **)private->jumpstack[cpu];
+	idx        = private->rule_index;
 
 	/* Switch to alternate jumpstack if we're being invoked via TEE.
 	 * TEE issues XT_CONTINUE verdict on original skb so we must not
@@ -283,7 +350,10 @@ ipt_do_table(void *priv,
 		if (!ip_packet_match(ip, indev, outdev,
 		    &e->ip, acpar.fragoff)) {
  no_match:
-			e = ipt_next_entry(e);
+			if (idx)
+				e = ipt_idx_next(idx, table_base, e, ip);
+			else
+				e = ipt_next_entry(e);
 			continue;
 		}
 
@@ -729,6 +799,10 @@ translate_table(struct net *net, struct xt_table_info *newinfo, void *entry0,
 		return ret;
 	}
 
+	newinfo->rule_index = xt_rule_index_build(entry0, newinfo->size,
+						  newinfo->number,
+						  &ipt_idx_ops);
+
 	return ret;
  out_free:
 	kvfree(offsets);
@@ -1081,7 +1155,7 @@ __do_replace(struct net *net, const char *name, unsigned int valid_hooks,
 	xt_entry_foreach(iter, oldinfo->entries, oldinfo->size)
 		cleanup_entry(iter, net);
 
-	xt_free_table_info(oldinfo);
+	ipt_free_table_info(oldinfo);
 	if (copy_to_user(counters_ptr, counters,
 			 sizeof(struct xt_counters) * num_counters) != 0) {
 		/* Silent error, can't fail, new table is already in place */
@@ -1148,7 +1222,7 @@ do_replace(struct net *net, sockptr_t arg, unsigned int len)
 	xt_entry_foreach(iter, loc_cpu_entry, newinfo->size)
 		cleanup_entry(iter, net);
  free_newinfo:
-	xt_free_table_info(newinfo);
+	ipt_free_table_info(newinfo);
 	return ret;
 }
 
@@ -1470,11 +1544,11 @@ translate_compat_table(struct net *net,
 
 	*pinfo = newinfo;
 	*pentry0 = entry1;
-	xt_free_table_info(info);
+	ipt_free_table_info(info);
 	return 0;
 
 free_newinfo:
-	xt_free_table_info(newinfo);
+	ipt_free_table_info(newinfo);
 	return ret;
 out_unlock:
 	xt_compat_flush_offsets(AF_INET);
@@ -1536,7 +1610,7 @@ compat_do_replace(struct net *net, sockptr_t arg, unsigned int len)
 	xt_entry_foreach(iter, loc_cpu_entry, newinfo->size)
 		cleanup_entry(iter, net);
  free_newinfo:
-	xt_free_table_info(newinfo);
+	ipt_free_table_info(newinfo);
 	return ret;
 }
 
@@ -1717,7 +1791,7 @@ static void __ipt_unregister_table(struct net *net, struct xt_table *table)
 		cleanup_entry(iter, net);
 	if (private->number > private->initial_entries)
 		module_put(table_owner);
-	xt_free_table_info(private);
+	ipt_free_table_info(private);
 }
 
 int ipt_register_table(struct net *net, const struct xt_table *table,
@@ -1741,7 +1815,7 @@ int ipt_register_table(struct net *net, const struct xt_table *table,
 
 	ret = translate_table(net, newinfo, loc_cpu_entry, repl);
 	if (ret != 0) {
-		xt_free_table_info(newinfo);
+		ipt_free_table_info(newinfo);
 		return ret;
 	}
 
@@ -1751,7 +1825,7 @@ int ipt_register_table(struct net *net, const struct xt_table *table,
 
 		xt_entry_foreach(iter, loc_cpu_entry, newinfo->size)
 			cleanup_entry(iter, net);
-		xt_free_table_info(newinfo);
+		ipt_free_table_info(newinfo);
 		return PTR_ERR(new_table);
 	}
 
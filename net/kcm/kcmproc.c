@@ -305,7 +305,7 @@ static int kcm_stats_seq_show(struct seq_file *seq, void *v)
 		   mux_stats.rx_ready_drops);
 
 	seq_printf(seq,
-		   "%-8s %-10s %-16s %-10s %-16s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s\n",
+		   "%-8s %-10s %-16s %-10s %-16s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s\n",
 		   "Psock",
 		   "RX-Msgs",
 		   "RX-Bytes",
@@ -321,10 +321,12 @@ static int kcm_stats_seq_show(struct seq_file *seq, void *v)
 		   "RX-BadLen",
 		   "RX-TooBig",
 		   "RX-Timeout",
-		   "TX-Aborts");
+		   "TX-Aborts",
+		   "TX-Pushes",
+		   "TX-B/Push");
 
 	seq_printf(seq,
-		   "%-8s %-10llu %-16llu %-10llu %-16llu %-10llu %-10llu %-10u %-10u %-10u %-10u %-10u %-10u %-10u %-10u %-10u\n",
+		   "%-8s %-10llu %-16llu %-10llu %-16llu %-10llu %-10llu %-10u %-10u %-10u %-10u %-10u %-10u %-10u %-10u %-10u %-10llu %-10llu\n",
 		   "",
 		   strp_stats.msgs,
 		   strp_stats.bytes,
@@ -340,7 +342,11 @@ static int kcm_stats_seq_show(struct seq_file *seq, void *v)
 		   strp_stats.bad_hdr_len,
 		   strp_stats.msg_too_big,
 		   strp_stats.msg_timeouts,
-		   psock_stats.tx_aborts);
+		   psock_stats.tx_aborts,
+		   psock_stats.tx_pushes,
+		   psock_stats.tx_pushes ?
+			div64_u64(psock_stats.tx_bytes,
+				  psock_stats.tx_pushes) : 0);
 
 	return 0;
 }
@@ -643,6 +643,14 @@ static int kcm_write_msgs(struct kcm_sock *kcm)
 			      skb_shinfo(skb)->nr_frags, msize);
 		iov_iter_advance(&msg.msg_iter, txm->frag_offset);
 
+		/* Let the lower socket coalesce the rest of this message and
+		 * any messages queued behind it; only the last piece of the
+		 * last queued message pushes.
+		 */
+		if ((skb == head ? skb_has_frag_list(skb) : !!skb->next) ||
+		    !skb_queue_is_last(&sk->sk_write_queue, head))
+			msg.msg_flags |= MSG_MORE;
+
 		do {
 			ret = sock_sendmsg(psock->sk->sk_socket, &msg);
 			if (ret <= 0) {
@@ -676,6 +684,9 @@ static int kcm_write_msgs(struct kcm_sock *kcm)
 			KCM_STATS_ADD(psock->stats.tx_bytes, ret);
 		} while (msg.msg_iter.count > 0);
 
+		if (!(msg.msg_flags & MSG_MORE))
+			KCM_STATS_INCR(psock->stats.tx_pushes);
+
 		if (skb == head) {
 			if (skb_has_frag_list(skb)) {
 				txm->frag_skb = skb_shinfo(skb)->frag_list;
@@ -980,6 +980,13 @@ void l2tp_recv_common(struct l2tp_session *session, struct sk_buff *skb,
 	if (L2TP_SKB_CB(skb)->has_seq) {
 		if (l2tp_recv_data_seq(session, skb))
 			goto discard;
+	} else if (skb_queue_empty_lockless(&session->reorder_q)) {
+		/* No sequence numbers and nothing held for reordering,
+		 * so nothing can be overtaken: deliver the skb straight
+		 * away instead of bouncing it through the queue lock.
+		 */
+		l2tp_recv_dequeue_skb(session, skb);
+		return;
 	} else {
 		/* No sequence numbers. Add the skb to the tail of the
 		 * reorder queue. This ensures that it will be
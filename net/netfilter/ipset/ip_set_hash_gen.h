@@ -45,17 +45,62 @@
 #define AHASH_MAX_TUNED			64
 #define AHASH_MAX(h)			((h)->bucketsize)
 
+/* Number of leading positions in an array block with a tag */
+#define AHASH_TAGS			8
+
 /* A hash bucket */
 struct hbucket {
 	struct rcu_head rcu;	/* for call_rcu */
 	/* Which positions are used in the array */
 	DECLARE_BITMAP(used, AHASH_MAX_TUNED);
+	u64 tags;		/* hash tags of the first AHASH_TAGS values */
 	u8 size;		/* size of the array */
 	u8 pos;			/* position of the first free entry */
 	unsigned char value[]	/* the array of the values */
 		__aligned(__alignof__(u64));
 };
 
+/* Lookups compare the tags, the top byte of the full hash, of the first
+ * AHASH_TAGS positions in one go and only look at the values whose tag
+ * matches: most mismatches then cost no cache miss on the values.
+ * Positions from AHASH_TAGS on are always compared.  Tags of unused
+ * positions are stale, the used bitmap is authoritative.
+ */
+#define ahash_tag(hash)		((u8)((hash) >> 24))
+#define AHASH_TAG_ONES		0x0101010101010101ULL
+#define AHASH_TAG_HIGHS		0x8080808080808080ULL
+
+static inline void
+ahash_set_tag(struct hbucket *n, u32 i, u8 tag)
+{
+	u64 tags;
+
+	if (i >= AHASH_TAGS)
+		return;
+	tags = n->tags & ~(0xffULL << (i * 8));
+	WRITE_ONCE(n->tags, tags | ((u64)tag << (i * 8)));
+}
+
+static inline u8
+ahash_get_tag(const struct hbucket *n, u32 i)
+{
+	return n->tags >> (i * 8);
+}
+
+/* Returns the high bit of each byte whose tag may equal @tag; bytes above
+ * a real match may be flagged spuriously, which only costs a compare.
+ */
+static inline u64
+ahash_tag_match(const struct hbucket *n, u8 tag)
+{
+	u64 x = READ_ONCE(n->tags) ^ (AHASH_TAG_ONES * tag);
+
+	return (x - AHASH_TAG_ONES) & ~x & AHASH_TAG_HIGHS;
+}
+
+#define ahash_tag_candidate(match, i)	\
+	((i) >= AHASH_TAGS || ((match) & (0x80ULL << ((i) * 8))))
+
 /* Region size for locking == 2^HTABLE_REGION_BITS */
 #define HTABLE_REGION_BITS	10
 #define ahash_numof_locks(htable_bits)		\
@@ -225,8 +270,10 @@ static const union nf_inet_addr zeromask = {};
 #undef mtype_cancel_gc
 #undef mtype_variant
 #undef mtype_data_match
+#undef mtype_elem_tag
 
 #undef htype
+#undef HHASH
 #undef HKEY
 
 #define mtype_data_equal	IPSET_TOKEN(MTYPE, _data_equal)
@@ -270,6 +317,7 @@ static const union nf_inet_addr zeromask = {};
 #define mtype_cancel_gc		IPSET_TOKEN(MTYPE, _cancel_gc)
 #define mtype_variant		IPSET_TOKEN(MTYPE, _variant)
 #define mtype_data_match	IPSET_TOKEN(MTYPE, _data_match)
+#define mtype_elem_tag		IPSET_TOKEN(MTYPE, _elem_tag)
 
 #ifndef HKEY_DATALEN
 #define HKEY_DATALEN		sizeof(struct mtype_elem)
@@ -277,16 +325,19 @@ static const union nf_inet_addr zeromask = {};
 
 #define htype			MTYPE
 
-#define HKEY(data, initval, htable_bits)			\
+#define HHASH(data, initval)					\
 ({								\
 	const u32 *__k = (const u32 *)data;			\
 	u32 __l = HKEY_DATALEN / sizeof(u32);			\
 								\
 	BUILD_BUG_ON(HKEY_DATALEN % sizeof(u32) != 0);		\
 								\
-	jhash2(__k, __l, initval) & jhash_mask(htable_bits);	\
+	jhash2(__k, __l, initval);				\
 })
 
+#define HKEY(data, initval, htable_bits)			\
+	(HHASH(data, initval) & jhash_mask(htable_bits))
+
 /* The generic hash structure */
 struct htype {
 	struct htable __rcu *table; /* the hash table */
@@ -382,6 +433,26 @@ mtype_ahash_memsize(const struct htype *h, const struct htable *t)
 #define ahash_data(n, i, dsize)	\
 	((struct mtype_elem *)((n)->value + ((i) * (dsize))))
 
+/* Tag of a stored element: its flags are not part of the hash */
+static u8
+mtype_elem_tag(const struct htype *h, const struct mtype_elem *data)
+{
+#ifdef IP_SET_HASH_WITH_NETS
+	struct mtype_elem e;
+	u8 flags = 0;
+
+	memcpy(&e, data, sizeof(e));
+	mtype_data_reset_flags(&e, &flags);
+	return ahash_tag(HHASH(&e, h->initval));
+#else
+	return ahash_tag(HHASH(data, h->initval));
+#endif
+}
+
+/* Tag of the element at position j of n when moved to a new position */
+#define ahash_move_tag(h, n, j, data)			\
+	((j) < AHASH_TAGS ? ahash_get_tag(n, j) : mtype_elem_tag(h, data))
+
 static void
 mtype_ext_cleanup(struct ip_set *set, struct hbucket *n)
 {
@@ -540,6 +611,8 @@ mtype_gc_do(struct ip_set *set, struct htype *h, struct htable *t, u32 r)
 				data = ahash_data(n, j, dsize);
 				memcpy(tmp->value + d * dsize,
 				       data, dsize);
+				ahash_set_tag(tmp, d,
+					      ahash_move_tag(h, n, j, data));
 				set_bit(d, tmp->used);
 				d++;
 			}
@@ -634,7 +707,7 @@ mtype_resize(struct ip_set *set, bool retried)
 	struct hbucket *n, *m;
 	struct list_head *l, *lt;
 	struct mtype_resize_ad *x;
-	u32 i, j, r, nr, key;
+	u32 i, j, r, nr, key, hash, elements;
 	int ret;
 
 #ifdef IP_SET_HASH_WITH_NETS
@@ -645,6 +718,15 @@ mtype_resize(struct ip_set *set, bool retried)
 	orig = ipset_dereference_bh_nfnl(h->table);
 	htable_bits = orig->htable_bits;
 
+	/* When a set is bulk loaded, a bucket fills up while the average
+	 * load is still low.  Size the new table for the elements already
+	 * stored instead of doubling once per overflowing bucket.
+	 */
+	for (r = 0, elements = 0; r < ahash_numof_locks(orig->htable_bits); r++)
+		elements += orig->hregion[r].elements;
+	if (fls(elements) - 1 > htable_bits)
+		htable_bits = fls(elements) - 1;
+
 retry:
 	ret = 0;
 	htable_bits++;
@@ -700,7 +782,8 @@ mtype_resize(struct ip_set *set, bool retried)
 				data = tmp;
 				mtype_data_reset_flags(data, &flags);
 #endif
-				key = HKEY(data, h->initval, htable_bits);
+				hash = HHASH(data, h->initval);
+				key = hash & jhash_mask(htable_bits);
 				m = __ipset_dereference(hbucket(t, key));
 				nr = ahash_region(key);
 				if (!m) {
@@ -743,6 +826,7 @@ mtype_resize(struct ip_set *set, bool retried)
 				}
 				d = ahash_data(m, m->pos, dsize);
 				memcpy(d, data, dsize);
+				ahash_set_tag(m, m->pos, ahash_tag(hash));
 				set_bit(m->pos++, m->used);
 				t->hregion[nr].elements++;
 #ifdef IP_SET_HASH_WITH_NETS
@@ -847,11 +931,12 @@ mtype_add(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 	int i, j = -1, ret;
 	bool flag_exist = flags & IPSET_FLAG_EXIST;
 	bool deleted = false, forceadd = false, reuse = false;
-	u32 r, key, multi = 0, elements, maxelem;
+	u32 r, key, hash, multi = 0, elements, maxelem;
 
 	rcu_read_lock_bh();
 	t = rcu_dereference_bh(h->table);
-	key = HKEY(value, h->initval, t->htable_bits);
+	hash = HHASH(value, h->initval);
+	key = hash & jhash_mask(t->htable_bits);
 	r = ahash_region(key);
 	atomic_inc(&t->uref);
 	elements = t->hregion[r].elements;
@@ -971,6 +1056,7 @@ mtype_add(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 		mtype_add_cidr(set, h, NCIDR_PUT(DCIDR_GET(d->cidr, i)), i);
 #endif
 	memcpy(data, d, sizeof(struct mtype_elem));
+	ahash_set_tag(n, j, ahash_tag(hash));
 overwrite_extensions:
 #ifdef IP_SET_HASH_WITH_NETS
 	mtype_data_set_flags(data, flags);
@@ -1115,6 +1201,8 @@ mtype_del(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 					continue;
 				data = ahash_data(n, j, dsize);
 				memcpy(tmp->value + k * dsize, data, dsize);
+				ahash_set_tag(tmp, k,
+					      ahash_move_tag(h, n, j, data));
 				set_bit(k, tmp->used);
 				k++;
 			}
@@ -1170,7 +1258,8 @@ mtype_test_cidrs(struct ip_set *set, struct mtype_elem *d,
 #else
 	int ret, i, j = 0;
 #endif
-	u32 key, multi = 0;
+	u32 key, hash, multi = 0;
+	u64 match;
 
 	pr_debug("test by nets\n");
 	for (; j < NLEN && h->nets[j].cidr[0] && !multi; j++) {
@@ -1184,12 +1273,15 @@ mtype_test_cidrs(struct ip_set *set, struct mtype_elem *d,
 #else
 		mtype_data_netmask(d, NCIDR_GET(h->nets[j].cidr[0]));
 #endif
-		key = HKEY(d, h->initval, t->htable_bits);
+		hash = HHASH(d, h->initval);
+		key = hash & jhash_mask(t->htable_bits);
 		n = rcu_dereference_bh(hbucket(t, key));
 		if (!n)
 			continue;
+		match = ahash_tag_match(n, ahash_tag(hash));
 		for (i = 0; i < n->pos; i++) {
-			if (!test_bit(i, n->used))
+			if (!ahash_tag_candidate(match, i) ||
+			    !test_bit(i, n->used))
 				continue;
 			data = ahash_data(n, i, set->dsize);
 			if (!mtype_data_equal(data, d, &multi))
@@ -1221,7 +1313,8 @@ mtype_test(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 	struct hbucket *n;
 	struct mtype_elem *data;
 	int i, ret = 0;
-	u32 key, multi = 0;
+	u32 key, hash, multi = 0;
+	u64 match;
 
 	rcu_read_lock_bh();
 	t = rcu_dereference_bh(h->table);
@@ -1238,14 +1331,16 @@ mtype_test(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 	}
 #endif
 
-	key = HKEY(d, h->initval, t->htable_bits);
+	hash = HHASH(d, h->initval);
+	key = hash & jhash_mask(t->htable_bits);
 	n = rcu_dereference_bh(hbucket(t, key));
 	if (!n) {
 		ret = 0;
 		goto out;
 	}
+	match = ahash_tag_match(n, ahash_tag(hash));
 	for (i = 0; i < n->pos; i++) {
-		if (!test_bit(i, n->used))
+		if (!ahash_tag_candidate(match, i) || !test_bit(i, n->used))
 			continue;
 		data = ahash_data(n, i, set->dsize);
 		if (!mtype_data_equal(data, d, &multi))
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Rule lookup index for large x_tables style rulesets.
+ *
+ * Every rule has a selector: a packet key of ops->key_words words can only
+ * match the rule if it equals the rule's value under the rule's mask.
+ * Rules are grouped into tuples by mask and hashed on their masked value
+ * within each tuple, and every hash node lists its rules in table order.
+ * When a rule does not match, the next rule worth looking at is the first
+ * later rule whose selector accepts the packet key: everything in between
+ * would fail the table's own match anyway.  The index is only a prefilter,
+ * candidates are still matched in full, so a table may leave out of the
+ * key whatever it cannot express as a masked compare (inverted selectors,
+ * wildcards, extension matches).
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#include <linux/jhash.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/netfilter/x_tables.h>
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("x_tables rule lookup index");
+
+static unsigned int classify_min_rules __read_mostly;
+module_param(classify_min_rules, uint, 0644);
+MODULE_PARM_DESC(classify_min_rules,
+		 "Index tables with at least this many rules (0 = never)");
+
+static inline u32 xt_rule_index_hash(const u32 *key, unsigned int words)
+{
+	return jhash2(key, words, 0);
+}
+
+/* Returns the node of @tp holding @key, or XT_RULE_INDEX_NONE */
+static u32 xt_rule_index_find(const struct xt_rule_index *idx,
+			      const struct xt_rule_index_tuple *tp,
+			      const u32 *key)
+{
+	unsigned int words = idx->key_words;
+	u32 k;
+
+	k = tp->buckets[xt_rule_index_hash(key, words) & tp->hmask];
+	for (; k != XT_RULE_INDEX_NONE; k = idx->nodes[k].next)
+		if (!memcmp(&idx->keys[k * words], key, words * sizeof(u32)))
+			break;
+	return k;
+}
+
+/**
+ * xt_rule_index_build - build a rule lookup index for a table
+ * @base: first entry of the table
+ * @size: size of the table's entries, in bytes
+ * @nrules: number of rules in the table
+ * @ops: how to walk the table and extract each rule's selector
+ *
+ * Returns NULL if the table is below the classify_min_rules threshold, if
+ * its rules need more than XT_RULE_INDEX_MAX_TUPLES distinct masks (a
+ * linear walk is cheaper then) or on allocation failure.  The table keeps
+ * its linear walk in all those cases.
+ */
+struct xt_rule_index *
+xt_rule_index_build(const void *base, unsigned int size, unsigned int nrules,
+		    const struct xt_rule_index_ops *ops)
+{
+	unsigned int n = nrules, words = ops->key_words, min_rules;
+	unsigned int off, i, t, w, nnodes = 0, nbuckets = 0;
+	u32 counts[XT_RULE_INDEX_MAX_TUPLES] = {};
+	u32 mask[XT_RULE_INDEX_MAX_WORDS], val[XT_RULE_INDEX_MAX_WORDS];
+	u32 *buckets, *rnode, *vals;
+	struct xt_rule_index *idx;
+	size_t idx_size;
+
+	min_rules = READ_ONCE(classify_min_rules);
+	if (!min_rules || n < min_rules ||
+	    WARN_ON_ONCE(!words || words > XT_RULE_INDEX_MAX_WORDS))
+		return NULL;
+
+	/* every tuple gets a power of two buckets, fewer than 2 per rule */
+	idx_size = sizeof(*idx) + n * (2 * sizeof(u32) +
+				       sizeof(struct xt_rule_index_node) +
+				       words * sizeof(u32)) +
+		   2 * n * sizeof(u32);
+	idx = kvzalloc(idx_size, GFP_KERNEL_ACCOUNT);
+	if (!idx)
+		return NULL;
+	rnode = kvmalloc_array(n, (words + 1) * sizeof(u32), GFP_KERNEL);
+	if (!rnode)
+		goto err;
+	vals = rnode + n;
+
+	idx->key_words = words;
+	idx->nrules = n;
+	idx->offsets = (u32 *)(idx + 1);
+	idx->rules = idx->offsets + n;
+	idx->nodes = (struct xt_rule_index_node *)(idx->rules + n);
+	idx->keys = (u32 *)(idx->nodes + n);
+	buckets = idx->keys + n * words;
+
+	/* Pass one: assign each rule to a tuple, kept in ->rules for now. */
+	for (off = 0, i = 0; off < size; ) {
+		const void *e = base + off;
+
+		off += ops->entry_size(e);
+		if (!ops->rule_key(e, mask, val))
+			continue;
+		if (WARN_ON_ONCE(i == n))
+			goto err;
+
+		for (w = 0; w < words; w++)
+			vals[i * words + w] = val[w] & mask[w];
+		for (t = 0; t < idx->ntuples; t++)
+			if (!memcmp(idx->tuples[t].mask, mask,
+				    words * sizeof(u32)))
+				break;
+		if (t == idx->ntuples) {
+			/* too many tuples to beat a linear walk */
+			if (t == XT_RULE_INDEX_MAX_TUPLES)
+				goto err;
+			memcpy(idx->tuples[t].mask, mask, words * sizeof(u32));
+			idx->ntuples++;
+		}
+		counts[t]++;
+		idx->offsets[i] = e - base;
+		idx->rules[i++] = t;
+	}
+	if (WARN_ON_ONCE(i != n))
+		goto err;
+
+	for (t = 0; t < idx->ntuples; t++) {
+		u32 nb = roundup_pow_of_two(counts[t]);
+
+		idx->tuples[t].buckets = buckets + nbuckets;
+		idx->tuples[t].hmask = nb - 1;
+		memset(idx->tuples[t].buckets, 0xff, nb * sizeof(u32));
+		nbuckets += nb;
+	}
+
+	/* Pass two: find or create the node holding each rule's key. */
+	for (i = 0; i < n; i++) {
+		struct xt_rule_index_tuple *tp = &idx->tuples[idx->rules[i]];
+		const u32 *v = &vals[i * words];
+		u32 k = xt_rule_index_find(idx, tp, v);
+
+		if (k == XT_RULE_INDEX_NONE) {
+			u32 *head = &tp->buckets[xt_rule_index_hash(v, words) &
+						 tp->hmask];
+
+			k = nnodes++;
+			memcpy(&idx->keys[k * words], v, words * sizeof(u32));
+			idx->nodes[k].next = *head;
+			*head = k;
+		}
+		idx->nodes[k].count++;
+		rnode[i] = k;
+	}
+
+	/* Pass three: lay out each node's rules in ascending order. */
+	for (i = 0, t = 0; i < nnodes; i++) {
+		idx->nodes[i].first = t;
+		t += idx->nodes[i].count;
+		idx->nodes[i].count = 0;
+	}
+	for (i = 0; i < n; i++) {
+		struct xt_rule_index_node *node = &idx->nodes[rnode[i]];
+
+		idx->rules[node->first + node->count++] = i;
+	}
+
+	kvfree(rnode);
+	return idx;
+err:
+	kvfree(rnode);
+	kvfree(idx);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(xt_rule_index_build);
+
+/**
+ * xt_rule_index_pos - number of the rule at an entry offset
+ * @idx: rule lookup index
+ * @offset: offset of a rule from the first entry of the table
+ */
+u32 xt_rule_index_pos(const struct xt_rule_index *idx, unsigned int offset)
+{
+	u32 lo = 0, hi = idx->nrules - 1;
+
+	while (lo < hi) {
+		u32 mid = lo + (hi - lo) / 2;
+
+		if (idx->offsets[mid] < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+EXPORT_SYMBOL_GPL(xt_rule_index_pos);
+
+/**
+ * xt_rule_index_next - next rule a packet can match
+ * @idx: rule lookup index
+ * @pos: number of the rule the packet just failed
+ * @key: the packet's key, @idx->key_words words
+ *
+ * Returns the number of the first rule after @pos whose selector accepts
+ * @key, or XT_RULE_INDEX_NONE.  The caller bounds the result to the chain
+ * it is walking.
+ *
+ * Performance critical.
+ */
+u32 xt_rule_index_next(const struct xt_rule_index *idx, u32 pos,
+		       const u32 *key)
+{
+	unsigned int words = idx->key_words;
+	u32 best = XT_RULE_INDEX_NONE;
+	u32 masked[XT_RULE_INDEX_MAX_WORDS];
+	unsigned int t, w;
+
+	for (t = 0; t < idx->ntuples; t++) {
+		const struct xt_rule_index_tuple *tp = &idx->tuples[t];
+		const struct xt_rule_index_node *node;
+		u32 k, lo, hi;
+
+		for (w = 0; w < words; w++)
+			masked[w] = key[w] & tp->mask[w];
+		k = xt_rule_index_find(idx, tp, masked);
+		if (k == XT_RULE_INDEX_NONE)
+			continue;
+		node = &idx->nodes[k];
+
+		/* first rule of this node after @pos */
+		lo = node->first;
+		hi = node->first + node->count;
+		while (lo < hi) {
+			u32 mid = lo + (hi - lo) / 2;
+
+			if (idx->rules[mid] <= pos)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < node->first + node->count && idx->rules[lo] < best)
+			best = idx->rules[lo];
+	}
+
+	return best;
+}
+EXPORT_SYMBOL_GPL(xt_rule_index_next);
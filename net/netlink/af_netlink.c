@@ -1707,6 +1707,9 @@ static int netlink_setsockopt(struct socket *sock, int level, int optname,
 	case NETLINK_GET_STRICT_CHK:
 		nr = NETLINK_F_STRICT_CHK;
 		break;
+	case NETLINK_DUMP_BATCH:
+		nr = NETLINK_F_DUMP_BATCH;
+		break;
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -1774,6 +1777,9 @@ static int netlink_getsockopt(struct socket *sock, int level, int optname,
 	case NETLINK_GET_STRICT_CHK:
 		flag = NETLINK_F_STRICT_CHK;
 		break;
+	case NETLINK_DUMP_BATCH:
+		flag = NETLINK_F_DUMP_BATCH;
+		break;
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -1898,6 +1904,54 @@ static int netlink_sendmsg(struct socket *sock, struct msghdr *msg, size_t len)
 	return err;
 }
 
+/* NETLINK_DUMP_BATCH: after the first skb has been copied, keep moving
+ * whole skbs from the same sender into the remaining @room of the user
+ * buffer, refilling the queue from a running dump as we go, so that a
+ * large dump needs one recvmsg() per buffer rather than per skb.
+ */
+static size_t netlink_recvmsg_batch(struct sock *sk, struct msghdr *msg,
+				    size_t room, u32 portid)
+{
+	struct sk_buff_head *queue = &sk->sk_receive_queue;
+	struct netlink_sock *nlk = nlk_sk(sk);
+	struct sk_buff *skb;
+	size_t copied = 0;
+	int ret;
+
+	for (;;) {
+		if (READ_ONCE(nlk->cb_running) &&
+		    atomic_read(&sk->sk_rmem_alloc) <= sk->sk_rcvbuf / 2) {
+			ret = netlink_dump(sk, false);
+			if (ret) {
+				WRITE_ONCE(sk->sk_err, -ret);
+				sk_error_report(sk);
+				break;
+			}
+		}
+
+		spin_lock_bh(&queue->lock);
+		skb = skb_peek(queue);
+		if (!skb || skb->len > room - copied ||
+		    NETLINK_CB(skb).portid != portid ||
+		    NETLINK_CB(skb).dst_group ||
+		    skb_has_frag_list(skb)) {
+			spin_unlock_bh(&queue->lock);
+			break;
+		}
+		__skb_unlink(skb, queue);
+		spin_unlock_bh(&queue->lock);
+
+		if (skb_copy_datagram_msg(skb, 0, msg, skb->len)) {
+			skb_queue_head(queue, skb);
+			break;
+		}
+		copied += skb->len;
+		skb_free_datagram(sk, skb);
+	}
+
+	return copied;
+}
+
 static int netlink_recvmsg(struct socket *sock, struct msghdr *msg, size_t len,
 			   int flags)
 {
@@ -1906,7 +1960,9 @@ static int netlink_recvmsg(struct socket *sock, struct msghdr *msg, size_t len,
 	struct netlink_sock *nlk = nlk_sk(sk);
 	size_t copied, max_recvmsg_len;
 	struct sk_buff *skb, *data_skb;
+	bool batch;
 	int err, ret;
+	u32 portid;
 
 	if (flags & MSG_OOB)
 		return -EOPNOTSUPP;
@@ -1969,8 +2025,15 @@ static int netlink_recvmsg(struct socket *sock, struct msghdr *msg, size_t len,
 	if (flags & MSG_TRUNC)
 		copied = data_skb->len;
 
+	batch = nlk_test_bit(DUMP_BATCH, sk) && !err && data_skb == skb &&
+		!(flags & (MSG_PEEK | MSG_TRUNC)) &&
+		!(msg->msg_flags & MSG_TRUNC) && !NETLINK_CB(skb).dst_group;
+	portid = NETLINK_CB(skb).portid;
 	skb_free_datagram(sk, skb);
 
+	if (batch)
+		copied += netlink_recvmsg_batch(sk, msg, len - copied, portid);
+
 	if (READ_ONCE(nlk->cb_running) &&
 	    atomic_read(&sk->sk_rmem_alloc) <= sk->sk_rcvbuf / 2) {
 		ret = netlink_dump(sk, false);
@@ -1360,6 +1360,20 @@ static unsigned int fanout_demux_hash(struct packet_fanout *f,
 	return reciprocal_scale(__skb_get_hash_symmetric(skb), num);
 }
 
+/* Use the flow hash the device computed (RSS), which costs nothing per
+ * packet.  Unlike PACKET_FANOUT_HASH it is only symmetric if the device's
+ * RSS key is, so both directions of a flow may land on different members.
+ */
+static unsigned int fanout_demux_rxhash(struct packet_fanout *f,
+					struct sk_buff *skb,
+					unsigned int num)
+{
+	if (skb->l4_hash)
+		return reciprocal_scale(skb->hash, num);
+
+	return fanout_demux_hash(f, skb, num);
+}
+
 static unsigned int fanout_demux_lb(struct packet_fanout *f,
 				    struct sk_buff *skb,
 				    unsigned int num)
@@ -1487,6 +1501,9 @@ static int packet_rcv_fanout(struct sk_buff *skb, struct net_device *dev,
 	case PACKET_FANOUT_QM:
 		idx = fanout_demux_qm(f, skb, num);
 		break;
+	case PACKET_FANOUT_RXHASH:
+		idx = fanout_demux_rxhash(f, skb, num);
+		break;
 	case PACKET_FANOUT_ROLLOVER:
 		idx = fanout_demux_rollover(f, skb, 0, false, num);
 		break;
@@ -1694,6 +1711,7 @@ static int fanout_add(struct sock *sk, struct fanout_args *args)
 	case PACKET_FANOUT_CPU:
 	case PACKET_FANOUT_RND:
 	case PACKET_FANOUT_QM:
+	case PACKET_FANOUT_RXHASH:
 	case PACKET_FANOUT_CBPF:
 	case PACKET_FANOUT_EBPF:
 		break;
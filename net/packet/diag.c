@@ -126,6 +126,32 @@ static int pdiag_put_fanout(struct packet_sock *po, struct sk_buff *nlskb)
 	return ret;
 }
 
+static int pdiag_put_stats(struct packet_sock *po, struct sk_buff *nlskb)
+{
+	struct sock *sk = &po->sk;
+	struct packet_diag_stats pds = {};
+
+	spin_lock_bh(&sk->sk_receive_queue.lock);
+	if (po->tp_version == TPACKET_V3) {
+		pds.pds_packets = po->stats.stats3.tp_packets;
+		pds.pds_freeze_q_cnt = po->stats.stats3.tp_freeze_q_cnt;
+	} else {
+		pds.pds_packets = po->stats.stats1.tp_packets;
+	}
+	spin_unlock_bh(&sk->sk_receive_queue.lock);
+
+	pds.pds_drops = atomic_read(&po->tp_drops);
+	pds.pds_packets += pds.pds_drops;
+
+	if (po->rollover) {
+		pds.pds_rollover = atomic_long_read(&po->rollover->num);
+		pds.pds_rollover_huge = atomic_long_read(&po->rollover->num_huge);
+		pds.pds_rollover_failed = atomic_long_read(&po->rollover->num_failed);
+	}
+
+	return nla_put(nlskb, PACKET_DIAG_STATS, sizeof(pds), &pds);
+}
+
 static int sk_diag_fill(struct sock *sk, struct sk_buff *skb,
 			struct packet_diag_req *req,
 			bool may_report_filterinfo,
@@ -168,6 +194,10 @@ static int sk_diag_fill(struct sock *sk, struct sk_buff *skb,
 			pdiag_put_fanout(po, skb))
 		goto out_nlmsg_trim;
 
+	if ((req->pdiag_show & PACKET_SHOW_STATS) &&
+	    pdiag_put_stats(po, skb))
+		goto out_nlmsg_trim;
+
 	if ((req->pdiag_show & PACKET_SHOW_MEMINFO) &&
 	    sock_diag_put_meminfo(sk, skb, PACKET_DIAG_MEMINFO))
 		goto out_nlmsg_trim;
@@ -107,21 +107,19 @@ static int __strp_recv(read_descriptor_t *desc, struct sk_buff *orig_skb,
 		if (unlikely(orig_offset)) {
 			/* Getting data with a non-zero offset when a message is
 			 * in progress is not expected. If it does happen, we
-			 * need to clone and pull since we can't deal with
-			 * offsets in the skbs for a message expect in the head.
+			 * need a new skb starting at the offset since we can't
+			 * deal with offsets in the skbs for a message expect in
+			 * the head. pskb_extract() shares the page frags with
+			 * orig_skb rather than pulling the skipped bytes into
+			 * the linear area, so large messages are not copied.
 			 */
-			orig_skb = skb_clone(orig_skb, GFP_ATOMIC);
+			orig_skb = pskb_extract(orig_skb, orig_offset, orig_len,
+						GFP_ATOMIC);
 			if (!orig_skb) {
 				STRP_STATS_INCR(strp->stats.mem_fail);
 				desc->error = -ENOMEM;
 				return 0;
 			}
-			if (!pskb_pull(orig_skb, orig_offset)) {
-				STRP_STATS_INCR(strp->stats.mem_fail);
-				kfree_skb(orig_skb);
-				desc->error = -ENOMEM;
-				return 0;
-			}
 			cloned_orig = true;
 			orig_offset = 0;
 		}
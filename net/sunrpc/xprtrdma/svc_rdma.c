@@ -67,6 +67,8 @@ static unsigned int zero;
 
 struct percpu_counter svcrdma_stat_read;
 struct percpu_counter svcrdma_stat_recv;
+struct percpu_counter svcrdma_stat_rq_prod;
+struct percpu_counter svcrdma_stat_sq_prod;
 struct percpu_counter svcrdma_stat_sq_starve;
 struct percpu_counter svcrdma_stat_write;
 
@@ -184,12 +186,10 @@ static struct ctl_table svcrdma_parm_table[] = {
 	},
 	{
 		.procname	= "rdma_stat_rq_prod",
-		.data		= &svcrdma_stat_unused,
-		.maxlen		= sizeof(unsigned int),
+		.data		= &svcrdma_stat_rq_prod,
+		.maxlen		= SVCRDMA_COUNTER_BUFSIZ,
 		.mode		= 0644,
-		.proc_handler	= proc_dointvec_minmax,
-		.extra1		= &zero,
-		.extra2		= &zero,
+		.proc_handler	= svcrdma_counter_handler,
 	},
 	{
 		.procname	= "rdma_stat_sq_poll",
@@ -202,12 +202,10 @@ static struct ctl_table svcrdma_parm_table[] = {
 	},
 	{
 		.procname	= "rdma_stat_sq_prod",
-		.data		= &svcrdma_stat_unused,
-		.maxlen		= sizeof(unsigned int),
+		.data		= &svcrdma_stat_sq_prod,
+		.maxlen		= SVCRDMA_COUNTER_BUFSIZ,
 		.mode		= 0644,
-		.proc_handler	= proc_dointvec_minmax,
-		.extra1		= &zero,
-		.extra2		= &zero,
+		.proc_handler	= svcrdma_counter_handler,
 	},
 };
 
@@ -218,6 +216,8 @@ static void svc_rdma_proc_cleanup(void)
 	unregister_sysctl_table(svcrdma_table_header);
 	svcrdma_table_header = NULL;
 
+	percpu_counter_destroy(&svcrdma_stat_sq_prod);
+	percpu_counter_destroy(&svcrdma_stat_rq_prod);
 	percpu_counter_destroy(&svcrdma_stat_write);
 	percpu_counter_destroy(&svcrdma_stat_sq_starve);
 	percpu_counter_destroy(&svcrdma_stat_recv);
@@ -243,16 +243,26 @@ static int svc_rdma_proc_init(void)
 	rc = percpu_counter_init(&svcrdma_stat_write, 0, GFP_KERNEL);
 	if (rc)
 		goto err_sq;
+	rc = percpu_counter_init(&svcrdma_stat_rq_prod, 0, GFP_KERNEL);
+	if (rc)
+		goto err_write;
+	rc = percpu_counter_init(&svcrdma_stat_sq_prod, 0, GFP_KERNEL);
+	if (rc)
+		goto err_rq_prod;
 
 	svcrdma_table_header = register_sysctl("sunrpc/svc_rdma",
 					       svcrdma_parm_table);
 	if (!svcrdma_table_header)
-		goto err_write;
+		goto err_sq_prod;
 
 	return 0;
 
-err_write:
+err_sq_prod:
 	rc = -ENOMEM;
+	percpu_counter_destroy(&svcrdma_stat_sq_prod);
+err_rq_prod:
+	percpu_counter_destroy(&svcrdma_stat_rq_prod);
+err_write:
 	percpu_counter_destroy(&svcrdma_stat_write);
 err_sq:
 	percpu_counter_destroy(&svcrdma_stat_sq_starve);
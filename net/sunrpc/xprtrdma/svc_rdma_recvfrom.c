@@ -277,6 +277,7 @@ static bool svc_rdma_refresh_recvs(struct svcxprt_rdma *rdma,
 	if (!recv_chain)
 		return true;
 
+	percpu_counter_inc(&svcrdma_stat_rq_prod);
 	ret = ib_post_recv(rdma->sc_qp, recv_chain, &bad_wr);
 	if (ret)
 		goto err_free;
@@ -216,6 +216,7 @@ struct svc_rdma_send_ctxt *svc_rdma_send_ctxt_get(struct svcxprt_rdma *rdma)
 			ctxt->sc_xprt_buf, NULL);
 
 	svc_rdma_cc_init(rdma, &ctxt->sc_reply_info.wi_cc);
+	ctxt->sc_send_wr.next = NULL;
 	ctxt->sc_send_wr.num_sge = 0;
 	ctxt->sc_cur_sge_no = 0;
 	ctxt->sc_page_count = 0;
@@ -327,14 +328,111 @@ static void svc_rdma_wc_send(struct ib_cq *cq, struct ib_wc *wc)
 	svc_xprt_deferred_close(&rdma->sc_xprt);
 }
 
+/* Maximum number of Send contexts whose WR chains are linked
+ * together and handed to the provider in one ib_post_send() call.
+ */
+enum {
+	SVC_RDMA_SEND_BATCH	= 16,
+};
+
+static void svc_rdma_post_send_batch(struct svcxprt_rdma *rdma,
+				     struct svc_rdma_send_ctxt **batch,
+				     unsigned int count)
+{
+	struct ib_send_wr *first_wr[SVC_RDMA_SEND_BATCH];
+	int sqecount[SVC_RDMA_SEND_BATCH];
+	const struct ib_send_wr *bad_wr, *wr;
+	struct rpc_rdma_cid cid;
+	unsigned int i;
+	int ret;
+
+	/* Copy what the error flow needs to the stack: once posted,
+	 * any of these contexts can be released by svc_rdma_wc_send().
+	 */
+	for (i = 0; i < count; i++) {
+		first_wr[i] = batch[i]->sc_wr_chain;
+		sqecount[i] = batch[i]->sc_sqecount;
+		batch[i]->sc_send_wr.next = i + 1 < count ?
+					    batch[i + 1]->sc_wr_chain : NULL;
+		trace_svcrdma_post_send(batch[i]);
+	}
+	cid = batch[0]->sc_cid;
+	bad_wr = first_wr[0];
+
+	trace_svcrdma_sq_post_batch(rdma, &cid, count);
+	percpu_counter_inc(&svcrdma_stat_sq_prod);
+	ret = ib_post_send(rdma->sc_qp, first_wr[0], &bad_wr);
+	if (likely(!ret))
+		return;
+
+	trace_svcrdma_sq_post_err(rdma, &cid, ret);
+	svc_xprt_deferred_close(&rdma->sc_xprt);
+
+	/* WRs starting at @bad_wr were not posted, so they are safe to
+	 * walk. A context whose whole chain lies in that range will
+	 * never see a Send completion; release it and its SQEs here.
+	 * If even one WR of a context was posted, there will be a
+	 * Send completion that bumps sc_sq_avail.
+	 */
+	for (wr = bad_wr; wr; wr = wr->next)
+		for (i = 0; i < count; i++)
+			if (wr == first_wr[i])
+				goto release;
+	return;
+
+release:
+	for (; i < count; i++) {
+		svc_rdma_wake_send_waiters(rdma, sqecount[i]);
+		svc_rdma_send_ctxt_put(rdma, batch[i]);
+	}
+}
+
+/* Post every WR chain queued on sc_send_pending. Only one thread
+ * posts at a time; chains queued by other threads meanwhile are
+ * picked up and linked into the next ib_post_send() call, so that
+ * under load one doorbell covers the Replies of several RPCs.
+ */
+static void svc_rdma_flush_sends(struct svcxprt_rdma *rdma)
+{
+	struct svc_rdma_send_ctxt *batch[SVC_RDMA_SEND_BATCH];
+	struct svc_rdma_send_ctxt *ctxt, *next;
+	struct llist_node *list;
+	unsigned int count;
+
+	do {
+		if (test_and_set_bit_lock(RDMAXPRT_SQ_POSTING,
+					  &rdma->sc_flags))
+			return;
+
+		while ((list = llist_del_all(&rdma->sc_send_pending))) {
+			list = llist_reverse_order(list);
+			count = 0;
+			llist_for_each_entry_safe(ctxt, next, list, sc_node) {
+				batch[count++] = ctxt;
+				if (count == SVC_RDMA_SEND_BATCH) {
+					svc_rdma_post_send_batch(rdma, batch,
+								 count);
+					count = 0;
+				}
+			}
+			if (count)
+				svc_rdma_post_send_batch(rdma, batch, count);
+		}
+
+		clear_bit_unlock(RDMAXPRT_SQ_POSTING, &rdma->sc_flags);
+		smp_mb__after_atomic();
+	} while (!llist_empty(&rdma->sc_send_pending));
+}
+
 /**
  * svc_rdma_post_send - Post a WR chain to the Send Queue
  * @rdma: transport context
  * @ctxt: WR chain to post
  *
  * Copy fields in @ctxt to stack variables in order to guarantee
- * that these values remain available after the ib_post_send() call.
- * In some error flow cases, svc_rdma_wc_send() releases @ctxt.
+ * that these values remain available after the chain is queued.
+ * Once queued, @ctxt may be posted by another thread and released
+ * by svc_rdma_wc_send() before this function returns.
  *
  * Note there is potential for starvation when the Send Queue is
  * full because there is no order to when waiting threads are
@@ -342,17 +440,16 @@ static void svc_rdma_wc_send(struct ib_cq *cq, struct ib_wc *wc)
  * enough Send Queue that SQ exhaustion should be a rare event.
  *
  * Return values:
- *   %0: @ctxt's WR chain was posted successfully
+ *   %0: @ctxt's WR chain was queued for posting; the caller no
+ *       longer owns @ctxt
  *   %-ENOTCONN: The connection was lost
  */
 int svc_rdma_post_send(struct svcxprt_rdma *rdma,
 		       struct svc_rdma_send_ctxt *ctxt)
 {
-	struct ib_send_wr *first_wr = ctxt->sc_wr_chain;
 	struct ib_send_wr *send_wr = &ctxt->sc_send_wr;
-	const struct ib_send_wr *bad_wr = first_wr;
 	struct rpc_rdma_cid cid = ctxt->sc_cid;
-	int ret, sqecount = ctxt->sc_sqecount;
+	int sqecount = ctxt->sc_sqecount;
 
 	might_sleep();
 
@@ -381,20 +478,8 @@ int svc_rdma_post_send(struct svcxprt_rdma *rdma,
 			continue;
 		}
 
-		trace_svcrdma_post_send(ctxt);
-		ret = ib_post_send(rdma->sc_qp, first_wr, &bad_wr);
-		if (ret) {
-			trace_svcrdma_sq_post_err(rdma, &cid, ret);
-			svc_xprt_deferred_close(&rdma->sc_xprt);
-
-			/* If even one WR was posted, there will be a
-			 * Send completion that bumps sc_sq_avail.
-			 */
-			if (bad_wr == first_wr) {
-				svc_rdma_wake_send_waiters(rdma, sqecount);
-				break;
-			}
-		}
+		llist_add(&ctxt->sc_node, &rdma->sc_send_pending);
+		svc_rdma_flush_sends(rdma);
 		return 0;
 	}
 	return -ENOTCONN;
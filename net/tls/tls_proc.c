@@ -27,6 +27,8 @@ static const struct snmp_mib tls_mib_list[] = {
 	SNMP_MIB_ITEM("TlsTxRekeyOk", LINUX_MIB_TLSTXREKEYOK),
 	SNMP_MIB_ITEM("TlsTxRekeyError", LINUX_MIB_TLSTXREKEYERROR),
 	SNMP_MIB_ITEM("TlsRxRekeyReceived", LINUX_MIB_TLSRXREKEYRECEIVED),
+	SNMP_MIB_ITEM("TlsRxParallel", LINUX_MIB_TLSRXPARALLEL),
+	SNMP_MIB_ITEM("TlsRxDecryptAsync", LINUX_MIB_TLSRXDECRYPTASYNC),
 };
 
 static int tls_statistics_seq_show(struct seq_file *seq, void *v)
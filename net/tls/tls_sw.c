@@ -287,8 +287,10 @@ static int tls_do_decryption(struct sock *sk,
 	}
 
 	ret = crypto_aead_decrypt(aead_req);
-	if (ret == -EINPROGRESS)
+	if (ret == -EINPROGRESS) {
+		TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXDECRYPTASYNC);
 		return 0;
+	}
 
 	if (ret == -EBUSY) {
 		ret = tls_decrypt_async_wait(ctx);
@@ -2766,6 +2768,37 @@ int init_prot_info(struct tls_prot_info *prot,
 	return 0;
 }
 
+/* Wrap the RX cipher in pcrypt so that records handed to the async
+ * decrypt path are spread over padata's CPUs.  pcrypt serializes the
+ * completions, so records still complete in the order they were queued.
+ * TLS 1.3 has to look at the decrypted content type before it can go on
+ * to the next record, so it never decrypts asynchronously.
+ */
+static struct crypto_aead *tls_alloc_rx_aead(struct sock *sk,
+					     struct tls_context *ctx,
+					     const struct tls_crypto_info *info,
+					     const struct tls_cipher_desc *desc)
+{
+	char name[CRYPTO_MAX_ALG_NAME];
+	struct crypto_aead *aead;
+
+	if (!ctx->rx_parallel || info->version == TLS_1_3_VERSION)
+		goto serial;
+
+	if (snprintf(name, sizeof(name), "pcrypt(%s)",
+		     desc->cipher_name) >= sizeof(name))
+		goto serial;
+
+	aead = crypto_alloc_aead(name, 0, 0);
+	if (!IS_ERR(aead)) {
+		TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXPARALLEL);
+		return aead;
+	}
+
+serial:
+	return crypto_alloc_aead(desc->cipher_name, 0, 0);
+}
+
 static void tls_finish_key_update(struct sock *sk, struct tls_context *tls_ctx)
 {
 	struct tls_sw_context_rx *ctx = tls_ctx->priv_ctx_rx;
@@ -2836,7 +2869,11 @@ int tls_set_sw_offload(struct sock *sk, int tx,
 	rec_seq = crypto_info_rec_seq(src_crypto_info, cipher_desc);
 
 	if (!*aead) {
-		*aead = crypto_alloc_aead(cipher_desc->cipher_name, 0, 0);
+		if (tx)
+			*aead = crypto_alloc_aead(cipher_desc->cipher_name, 0, 0);
+		else
+			*aead = tls_alloc_rx_aead(sk, ctx, src_crypto_info,
+						  cipher_desc);
 		if (IS_ERR(*aead)) {
 			rc = PTR_ERR(*aead);
 			*aead = NULL;
@@ -637,6 +637,7 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge_reason(&sk->sk_receive_queue, SKB_DROP_REASON_SOCKET_CLOSE);
+	skb_queue_purge(&sk->sk_error_queue);
 
 	DEBUG_NET_WARN_ON_ONCE(refcount_read(&sk->sk_wmem_alloc));
 	DEBUG_NET_WARN_ON_ONCE(!sk_unhashed(sk));
@@ -921,6 +922,7 @@ static bool unix_custom_sockopt(int optname)
 {
 	switch (optname) {
 	case SO_INQ:
+	case SO_ZEROCOPY:
 		return true;
 	default:
 		return false;
@@ -956,6 +958,15 @@ static int unix_setsockopt(struct socket *sock, int level, int optname,
 
 		WRITE_ONCE(u->recvmsg_inq, val);
 		break;
+	case SO_ZEROCOPY:
+		if (sk->sk_type != SOCK_STREAM)
+			return -EOPNOTSUPP;
+
+		if (val > 1 || val < 0)
+			return -EINVAL;
+
+		sock_valbool_flag(sk, SOCK_ZEROCOPY, val);
+		break;
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -2371,6 +2382,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
 	struct sock *sk = sock->sk;
+	struct ubuf_info *uarg = NULL;
 	struct sk_buff *skb = NULL;
 	struct sock *other = NULL;
 	struct unix_sock *otheru;
@@ -2408,6 +2420,16 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (READ_ONCE(sk->sk_shutdown) & SEND_SHUTDOWN)
 		goto out_pipe;
 
+	if ((msg->msg_flags & MSG_ZEROCOPY) && len &&
+	    !(msg->msg_flags & MSG_SPLICE_PAGES) &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL, false);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		int size = len - sent;
 		int data_len;
@@ -2416,6 +2438,14 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			skb = sock_alloc_send_pskb(sk, 0, 0,
 						   msg->msg_flags & MSG_DONTWAIT,
 						   &err, 0);
+		} else if (uarg) {
+			/* The payload stays in the sender's pages, so only
+			 * bound the skb by the usual share of sk_sndbuf.
+			 */
+			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
 		} else {
 			/* Keep two messages in the pipe so it schedules better */
 			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
@@ -2453,6 +2483,17 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 
 			size = err;
 			refcount_add(size, &sk->sk_wmem_alloc);
+		} else if (uarg) {
+			/* Charges the pinned pages to sk_wmem_alloc.  Running
+			 * out of frags is not fatal, send what fit and loop.
+			 */
+			err = __zerocopy_sg_from_iter(msg, NULL, skb,
+						      &msg->msg_iter, size, NULL);
+			if (err && !(err == -EMSGSIZE && skb->len))
+				goto out_free;
+
+			size = skb->len;
+			skb_zcopy_set(skb, uarg, NULL);
 		} else {
 			skb_put(skb, size - data_len);
 			skb->data_len = data_len;
@@ -2495,6 +2536,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	}
 #endif
 
+	net_zcopy_put(uarg);
 	scm_destroy(&scm);
 
 	return sent;
@@ -2508,6 +2550,10 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 out_free:
 	consume_skb(skb);
 out_err:
+	if (sent)
+		net_zcopy_put(uarg);
+	else
+		net_zcopy_put_abort(uarg, true);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2887,6 +2933,12 @@ static int unix_stream_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 	spin_unlock(&queue->lock);
 	mutex_unlock(&u->iolock);
 
+	/* sockmap may hold on to the frags, see unix_stream_splice_actor() */
+	if (skb_orphan_frags_rx(skb, GFP_ATOMIC)) {
+		kfree_skb(skb);
+		return -ENOMEM;
+	}
+
 	return recv_actor(sk, skb);
 }
 
@@ -3139,6 +3191,10 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.flags = flags
 	};
 
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sock->sk, msg, size, SOL_SOCKET,
+					  SO_ZEROCOPY);
+
 #ifdef CONFIG_BPF_SYSCALL
 	struct sock *sk = sock->sk;
 	const struct proto *prot = READ_ONCE(sk->sk_prot);
@@ -3153,6 +3209,12 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	/* The pipe keeps the pages past consume_skb(), which completes a
+	 * MSG_ZEROCOPY send, so the sender's pages must be copied first.
+	 */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL))
+		return -ENOMEM;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -3351,7 +3413,8 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	state = READ_ONCE(sk->sk_state);
 
 	/* exceptional events? */
-	if (READ_ONCE(sk->sk_err))
+	if (READ_ONCE(sk->sk_err) ||
+	    !skb_queue_empty_lockless(&sk->sk_error_queue))
 		mask |= EPOLLERR;
 	if (shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
@@ -10,29 +10,66 @@
 #include <linux/spinlock.h>
 #include <linux/module.h>
 #include <linux/list.h>
+#include <linux/jhash.h>
+#include <linux/slab.h>
 #include <linux/virtio_vsock.h>
 
-struct vsock_loopback {
-	struct workqueue_struct *workqueue;
+#define VSOCK_LOOPBACK_MAX_QUEUES	64
 
+/* Packets are spread over several queues, each drained by its own work
+ * item, so that independent connections are delivered in parallel.  A
+ * connection always maps to the same queue, in both directions, which
+ * keeps its packets in order.
+ */
+struct vsock_loopback_queue {
 	struct sk_buff_head pkt_queue;
 	struct work_struct pkt_work;
 };
 
+struct vsock_loopback {
+	struct workqueue_struct *workqueue;
+
+	unsigned int nqueues;
+	struct vsock_loopback_queue *queues;
+};
+
 static struct vsock_loopback the_vsock_loopback;
 
+static unsigned int queues;
+module_param(queues, uint, 0444);
+MODULE_PARM_DESC(queues, "Number of delivery queues (default: one per online CPU)");
+
 static u32 vsock_loopback_get_local_cid(void)
 {
 	return VMADDR_CID_LOCAL;
 }
 
+static struct vsock_loopback_queue *
+vsock_loopback_pick_queue(struct vsock_loopback *vsock, struct sk_buff *skb)
+{
+	struct virtio_vsock_hdr *hdr = virtio_vsock_hdr(skb);
+	u32 src = le32_to_cpu(hdr->src_port);
+	u32 dst = le32_to_cpu(hdr->dst_port);
+
+	if (vsock->nqueues == 1)
+		return vsock->queues;
+
+	/* Both ends of a connection share the local CID, order the ports so
+	 * that either direction hashes the same.
+	 */
+	return &vsock->queues[reciprocal_scale(jhash_2words(min(src, dst),
+							    max(src, dst), 0),
+					       vsock->nqueues)];
+}
+
 static int vsock_loopback_send_pkt(struct sk_buff *skb, struct net *net)
 {
 	struct vsock_loopback *vsock = &the_vsock_loopback;
+	struct vsock_loopback_queue *q = vsock_loopback_pick_queue(vsock, skb);
 	int len = skb->len;
 
-	virtio_vsock_skb_queue_tail(&vsock->pkt_queue, skb);
-	queue_work(vsock->workqueue, &vsock->pkt_work);
+	virtio_vsock_skb_queue_tail(&q->pkt_queue, skb);
+	queue_work(vsock->workqueue, &q->pkt_work);
 
 	return len;
 }
@@ -40,8 +77,10 @@ static int vsock_loopback_send_pkt(struct sk_buff *skb, struct net *net)
 static int vsock_loopback_cancel_pkt(struct vsock_sock *vsk)
 {
 	struct vsock_loopback *vsock = &the_vsock_loopback;
+	unsigned int i;
 
-	virtio_transport_purge_skbs(vsk, &vsock->pkt_queue);
+	for (i = 0; i < vsock->nqueues; i++)
+		virtio_transport_purge_skbs(vsk, &vsock->queues[i].pkt_queue);
 
 	return 0;
 }
@@ -122,16 +161,16 @@ vsock_loopback_seqpacket_allow(struct vsock_sock *vsk, u32 remote_cid)
 
 static void vsock_loopback_work(struct work_struct *work)
 {
-	struct vsock_loopback *vsock =
-		container_of(work, struct vsock_loopback, pkt_work);
+	struct vsock_loopback_queue *q =
+		container_of(work, struct vsock_loopback_queue, pkt_work);
 	struct sk_buff_head pkts;
 	struct sk_buff *skb;
 
 	skb_queue_head_init(&pkts);
 
-	spin_lock_bh(&vsock->pkt_queue.lock);
-	skb_queue_splice_init(&vsock->pkt_queue, &pkts);
-	spin_unlock_bh(&vsock->pkt_queue.lock);
+	spin_lock_bh(&q->pkt_queue.lock);
+	skb_queue_splice_init(&q->pkt_queue, &pkts);
+	spin_unlock_bh(&q->pkt_queue.lock);
 
 	while ((skb = __skb_dequeue(&pkts))) {
 		/* Decrement the bytes_unsent counter without deallocating skb
@@ -147,14 +186,26 @@ static void vsock_loopback_work(struct work_struct *work)
 static int __init vsock_loopback_init(void)
 {
 	struct vsock_loopback *vsock = &the_vsock_loopback;
+	unsigned int i;
 	int ret;
 
-	vsock->workqueue = alloc_workqueue("vsock-loopback", WQ_PERCPU, 0);
-	if (!vsock->workqueue)
+	vsock->nqueues = clamp(queues ?: num_online_cpus(), 1U,
+			       VSOCK_LOOPBACK_MAX_QUEUES);
+	vsock->queues = kcalloc(vsock->nqueues, sizeof(*vsock->queues),
+				GFP_KERNEL);
+	if (!vsock->queues)
 		return -ENOMEM;
 
-	skb_queue_head_init(&vsock->pkt_queue);
-	INIT_WORK(&vsock->pkt_work, vsock_loopback_work);
+	vsock->workqueue = alloc_workqueue("vsock-loopback", WQ_PERCPU, 0);
+	if (!vsock->workqueue) {
+		ret = -ENOMEM;
+		goto out_queues;
+	}
+
+	for (i = 0; i < vsock->nqueues; i++) {
+		skb_queue_head_init(&vsock->queues[i].pkt_queue);
+		INIT_WORK(&vsock->queues[i].pkt_work, vsock_loopback_work);
+	}
 
 	ret = vsock_core_register(&loopback_transport.transport,
 				  VSOCK_TRANSPORT_F_LOCAL);
@@ -165,20 +216,25 @@ static int __init vsock_loopback_init(void)
 
 out_wq:
 	destroy_workqueue(vsock->workqueue);
+out_queues:
+	kfree(vsock->queues);
 	return ret;
 }
 
 static void __exit vsock_loopback_exit(void)
 {
 	struct vsock_loopback *vsock = &the_vsock_loopback;
+	unsigned int i;
 
 	vsock_core_unregister(&loopback_transport.transport);
 
-	flush_work(&vsock->pkt_work);
-
-	virtio_vsock_skb_queue_purge(&vsock->pkt_queue);
+	for (i = 0; i < vsock->nqueues; i++) {
+		flush_work(&vsock->queues[i].pkt_work);
+		virtio_vsock_skb_queue_purge(&vsock->queues[i].pkt_queue);
+	}
 
 	destroy_workqueue(vsock->workqueue);
+	kfree(vsock->queues);
 }
 
 module_init(vsock_loopback_init);
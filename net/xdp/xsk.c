@@ -53,6 +53,52 @@ void xsk_set_rx_need_wakeup(struct xsk_buff_pool *pool)
 }
 EXPORT_SYMBOL(xsk_set_rx_need_wakeup);
 
+/* A NAPI instance in threaded busy-poll mode drains the Tx ring on its own,
+ * so user space can keep producing descriptors without kicking it. This
+ * relies on the NAPI core calling xsk_napi_busy_poll_stopped().
+ */
+static bool xsk_tx_busy_polled(struct xsk_buff_pool *pool)
+{
+	struct net_device *dev = pool->netdev;
+	struct napi_struct *napi;
+
+	if (!IS_ENABLED(CONFIG_XDP_SOCKETS_TX_BUSY_POLL))
+		return false;
+
+	if (!pool->zc || pool->queue_id >= dev->real_num_rx_queues)
+		return false;
+
+	napi = READ_ONCE(__netif_get_rx_queue(dev, pool->queue_id)->napi);
+	return napi && test_bit(NAPI_STATE_THREADED_BUSY_POLL, &napi->state);
+}
+
+/* Returns true if the Tx wakeup request is left to the busy-polling NAPI
+ * thread. The deferral is published before the busy-poll state is checked
+ * again, pairing with xsk_napi_busy_poll_stopped(): either this re-check
+ * sees busy polling switched off and raises the flag itself, or the NAPI
+ * core sees the deferral and kicks the queue.
+ */
+static bool xsk_defer_tx_wakeup(struct xsk_buff_pool *pool)
+{
+	bool deferred;
+
+	if (!xsk_tx_busy_polled(pool))
+		return false;
+
+	deferred = READ_ONCE(pool->tx_wakeup_deferred);
+	WRITE_ONCE(pool->tx_wakeup_deferred, true);
+	smp_mb();
+	if (!xsk_tx_busy_polled(pool)) {
+		WRITE_ONCE(pool->tx_wakeup_deferred, false);
+		return false;
+	}
+
+	/* Count each wakeup user space would have needed, not each poll */
+	if (!deferred)
+		atomic64_inc(&pool->tx_wakeup_suppressed);
+	return true;
+}
+
 void xsk_set_tx_need_wakeup(struct xsk_buff_pool *pool)
 {
 	struct xdp_sock *xs;
@@ -60,6 +106,9 @@ void xsk_set_tx_need_wakeup(struct xsk_buff_pool *pool)
 	if (pool->cached_need_wakeup & XDP_WAKEUP_TX)
 		return;
 
+	if (xsk_defer_tx_wakeup(pool))
+		return;
+
 	rcu_read_lock();
 	list_for_each_entry_rcu(xs, &pool->xsk_tx_list, tx_list) {
 		xs->tx->ring->flags |= XDP_RING_NEED_WAKEUP;
@@ -84,6 +133,9 @@ void xsk_clear_tx_need_wakeup(struct xsk_buff_pool *pool)
 {
 	struct xdp_sock *xs;
 
+	if (READ_ONCE(pool->tx_wakeup_deferred))
+		WRITE_ONCE(pool->tx_wakeup_deferred, false);
+
 	if (!(pool->cached_need_wakeup & XDP_WAKEUP_TX))
 		return;
 
@@ -103,6 +155,41 @@ bool xsk_uses_need_wakeup(struct xsk_buff_pool *pool)
 }
 EXPORT_SYMBOL(xsk_uses_need_wakeup);
 
+/**
+ * xsk_napi_busy_poll_stopped - Kick queues that relied on busy polling
+ * @napi: NAPI instance that just left threaded busy-poll mode
+ *
+ * Tx wakeups deferred by xsk_set_tx_need_wakeup() while @napi was busy
+ * polling are never raised to user space, so the queue is kicked here
+ * once. The driver then finds the Tx ring empty from regular NAPI context
+ * and sets XDP_RING_NEED_WAKEUP the normal way. Must be called after
+ * NAPI_STATE_THREADED_BUSY_POLL has been cleared, with the netdev instance
+ * lock held.
+ */
+void xsk_napi_busy_poll_stopped(struct napi_struct *napi)
+{
+	struct net_device *dev = napi->dev;
+	struct xsk_buff_pool *pool;
+	unsigned int i;
+
+	if (!dev->netdev_ops->ndo_xsk_wakeup)
+		return;
+
+	smp_mb();
+	for (i = 0; i < dev->real_num_rx_queues; i++) {
+		if (READ_ONCE(__netif_get_rx_queue(dev, i)->napi) != napi)
+			continue;
+
+		pool = xsk_get_pool_from_qid(dev, i);
+		if (!pool || !READ_ONCE(pool->tx_wakeup_deferred))
+			continue;
+
+		WRITE_ONCE(pool->tx_wakeup_deferred, false);
+		dev->netdev_ops->ndo_xsk_wakeup(dev, i, XDP_WAKEUP_TX);
+	}
+}
+EXPORT_SYMBOL(xsk_napi_busy_poll_stopped);
+
 struct xsk_buff_pool *xsk_get_pool_from_qid(struct net_device *dev,
 					    u16 queue_id)
 {
@@ -536,6 +623,8 @@ static int xsk_wakeup(struct xdp_sock *xs, u8 flags)
 {
 	struct net_device *dev = xs->dev;
 
+	if (flags & XDP_WAKEUP_TX)
+		xs->tx_wakeup++;
 	return dev->netdev_ops->ndo_xsk_wakeup(dev, xs->queue_id, flags);
 }
 
@@ -1045,6 +1134,11 @@ static int __xsk_sendmsg(struct socket *sock, struct msghdr *m, size_t total_len
 		return 0;
 
 	pool = xs->pool;
+	if (xs->zc && xsk_tx_busy_polled(pool)) {
+		atomic64_inc(&pool->tx_wakeup_suppressed);
+		return 0;
+	}
+
 	if (pool->cached_need_wakeup & XDP_WAKEUP_TX) {
 		if (xs->zc)
 			return xsk_wakeup(xs, XDP_WAKEUP_TX);
@@ -1429,7 +1523,7 @@ static int xsk_bind(struct socket *sock, struct sockaddr_unsized *addr, int addr
 	xs->cq_tmp = NULL;
 
 	xs->dev = dev;
-	xs->zc = xs->umem->zc;
+	xs->zc = xs->pool->zc;
 	xs->sg = !!(xs->umem->flags & XDP_UMEM_SG_FLAG);
 	xs->queue_id = qid;
 	xp_add_xsk(xs->pool, xs);
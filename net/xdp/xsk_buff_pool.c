@@ -143,7 +143,7 @@ static void xp_disable_drv_zc(struct xsk_buff_pool *pool)
 
 	ASSERT_RTNL();
 
-	if (pool->umem->zc) {
+	if (pool->zc) {
 		bpf.command = XDP_SETUP_XSK_POOL;
 		bpf.xsk.pool = NULL;
 		bpf.xsk.queue_id = pool->queue_id;
@@ -225,6 +225,7 @@ int xp_assign_dev(struct xsk_buff_pool *pool,
 		err = -EINVAL;
 		goto err_unreg_xsk;
 	}
+	pool->zc = true;
 	pool->umem->zc = true;
 	pool->xdp_zc_max_segs = netdev->xdp_zc_max_segs;
 	return 0;
@@ -244,10 +245,15 @@ int xp_assign_dev(struct xsk_buff_pool *pool,
 int xp_assign_dev_shared(struct xsk_buff_pool *pool, struct xdp_sock *umem_xs,
 			 struct net_device *dev, u16 queue_id)
 {
-	u16 flags;
-	struct xdp_umem *umem = umem_xs->umem;
+	u16 flags = 0;
 
-	flags = umem->zc ? XDP_ZEROCOPY : XDP_COPY;
+	/* Queues of the same device keep the mode of the socket that owns
+	 * the umem.  Another device maps the umem on its own and picks
+	 * zero-copy when it can, so one umem may span a zero-copy NIC and
+	 * a copy-mode device and frames still move between them in place.
+	 */
+	if (dev == umem_xs->dev)
+		flags = umem_xs->pool->zc ? XDP_ZEROCOPY : XDP_COPY;
 	if (umem_xs->pool->uses_need_wakeup)
 		flags |= XDP_USE_NEED_WAKEUP;
 
@@ -62,7 +62,7 @@ static int xsk_diag_put_umem(const struct xdp_sock *xs, struct sk_buff *nlskb)
 	du.ifindex = (pool && pool->netdev) ? pool->netdev->ifindex : 0;
 	du.queue_id = pool ? pool->queue_id : 0;
 	du.flags = 0;
-	if (umem->zc)
+	if (pool ? pool->zc : umem->zc)
 		du.flags |= XDP_DU_F_ZEROCOPY;
 	du.refs = refcount_read(&umem->users);
 
@@ -86,6 +86,9 @@ static int xsk_diag_put_stats(const struct xdp_sock *xs, struct sk_buff *nlskb)
 	du.n_fill_ring_empty = xs->pool ? xskq_nb_queue_empty_descs(xs->pool->fq) : 0;
 	du.n_tx_invalid = xskq_nb_invalid_descs(xs->tx);
 	du.n_tx_ring_empty = xskq_nb_queue_empty_descs(xs->tx);
+	du.n_tx_wakeup = xs->tx_wakeup;
+	du.n_tx_wakeup_suppressed = xs->pool ?
+		atomic64_read(&xs->pool->tx_wakeup_suppressed) : 0;
 	return nla_put(nlskb, XDP_DIAG_STATS, sizeof(du), &du);
 }
 
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * unix-zerocopy.c
+ *
+ * unix-zerocopy: Bandwidth of AF_UNIX stream sockets with and without
+ * MSG_ZEROCOPY.
+ *
+ * A child process drains a socketpair while the parent streams fixed
+ * size messages into it.  With --zerocopy the sender enables SO_ZEROCOPY
+ * and reaps completion notifications from the error queue as it goes.
+ */
+#include <subcmd/parse-options.h>
+#include "bench.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <linux/errqueue.h>
+#include <linux/time64.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY	0x4000000
+#endif
+
+static unsigned int	msg_size = 1024 * 1024;
+static unsigned int	nr_msgs = 4096;
+static bool		zerocopy;
+
+static const struct option options[] = {
+	OPT_UINTEGER('s', "size", &msg_size, "Size of each send in bytes"),
+	OPT_UINTEGER('n', "nr", &nr_msgs, "Number of sends"),
+	OPT_BOOLEAN('z', "zerocopy", &zerocopy, "Send with MSG_ZEROCOPY"),
+	OPT_END()
+};
+
+static const char * const bench_unix_zerocopy_usage[] = {
+	"perf bench net unix-zerocopy <options>",
+	NULL
+};
+
+/* Returns the number of sends whose completion has been reported. */
+static unsigned int reap_completions(int fd)
+{
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct sock_extended_err *serr;
+	struct msghdr msg = {};
+	struct cmsghdr *cm;
+
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+		return 0;
+
+	cm = CMSG_FIRSTHDR(&msg);
+	if (!cm || cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SO_ZEROCOPY)
+		return 0;
+
+	serr = (void *)CMSG_DATA(cm);
+	if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+		return 0;
+
+	return serr->ee_data - serr->ee_info + 1;
+}
+
+static void receiver(int fd)
+{
+	char *buf = malloc(msg_size);
+
+	if (!buf)
+		exit(1);
+
+	while (read(fd, buf, msg_size) > 0)
+		;
+
+	free(buf);
+	exit(0);
+}
+
+static int sender(int fd)
+{
+	unsigned int i, pending = 0;
+	int flags = 0, one = 1;
+	char *buf;
+
+	buf = malloc(msg_size);
+	if (!buf)
+		return -1;
+	memset(buf, 0xa5, msg_size);
+
+	if (zerocopy) {
+		if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one))) {
+			fprintf(stderr, "SO_ZEROCOPY: %s\n", strerror(errno));
+			free(buf);
+			return -1;
+		}
+		flags = MSG_ZEROCOPY;
+	}
+
+	for (i = 0; i < nr_msgs; i++) {
+		size_t off = 0;
+
+		while (off < msg_size) {
+			ssize_t ret = send(fd, buf + off, msg_size - off, flags);
+
+			if (ret < 0) {
+				if (errno == ENOBUFS && zerocopy) {
+					pending -= reap_completions(fd);
+					continue;
+				}
+				fprintf(stderr, "send: %s\n", strerror(errno));
+				free(buf);
+				return -1;
+			}
+			off += ret;
+			if (zerocopy)
+				pending++;
+		}
+
+		while (zerocopy && pending) {
+			unsigned int done = reap_completions(fd);
+
+			if (!done)
+				break;
+			pending -= done;
+		}
+	}
+
+	while (zerocopy && pending) {
+		struct pollfd pfd = { .fd = fd, .events = 0 };
+
+		if (poll(&pfd, 1, 1000) <= 0)
+			break;
+		pending -= reap_completions(fd);
+	}
+
+	free(buf);
+	return 0;
+}
+
+int bench_net_unix_zerocopy(int argc, const char **argv)
+{
+	struct timeval start, stop, diff;
+	unsigned long long total, result_usec;
+	int sv[2], wait_stat;
+	pid_t pid;
+	int ret;
+
+	argc = parse_options(argc, argv, options, bench_unix_zerocopy_usage, 0);
+	if (argc || !msg_size || !nr_msgs)
+		usage_with_options(bench_unix_zerocopy_usage, options);
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) {
+		perror("socketpair");
+		return -1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+
+	if (!pid) {
+		close(sv[0]);
+		receiver(sv[1]);
+	}
+	close(sv[1]);
+
+	gettimeofday(&start, NULL);
+	ret = sender(sv[0]);
+	shutdown(sv[0], SHUT_WR);
+	waitpid(pid, &wait_stat, 0);
+	gettimeofday(&stop, NULL);
+	close(sv[0]);
+
+	if (ret)
+		return ret;
+
+	timersub(&stop, &start, &diff);
+	result_usec = diff.tv_sec * USEC_PER_SEC + diff.tv_usec;
+	total = (unsigned long long)msg_size * nr_msgs;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# Sent %u x %u bytes over AF_UNIX stream%s\n\n",
+		       nr_msgs, msg_size, zerocopy ? " with MSG_ZEROCOPY" : "");
+		printf(" %14s: %lu.%03lu [sec]\n\n", "Total time",
+		       (unsigned long) diff.tv_sec,
+		       (unsigned long) (diff.tv_usec / USEC_PER_MSEC));
+		printf(" %14lf MB/sec\n",
+		       (double)total / (double)result_usec);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%lf\n", (double)total / (double)result_usec);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	return 0;
+}
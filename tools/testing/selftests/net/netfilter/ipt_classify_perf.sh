@@ -0,0 +1,99 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Compare iptables packet rates with and without the ip_tables rule
+# lookup index (classify_min_rules) at 1K, 10K and 50K rules.
+#
+# pktgen sends UDP from ns1 over a veth pair into ns2, whose raw
+# PREROUTING chain holds N /32 source rules that never match followed by
+# a final counting rule.  The rate is what reaches that last rule.
+
+source lib.sh
+
+PARAM=/sys/module/xt_rule_index/parameters/classify_min_rules
+DURATION=${DURATION:-5}
+RULES=${RULES:-"1000 10000 50000"}
+
+checktool "iptables-restore --version" "run test without iptables-restore"
+
+modprobe -q ip_tables
+modprobe -q xt_rule_index
+modprobe -q pktgen
+if [ ! -w "$PARAM" ] || [ ! -d /proc/net/pktgen ]; then
+	echo "SKIP: xt_rule_index classify_min_rules or pktgen not available"
+	exit $ksft_skip
+fi
+
+orig=$(cat "$PARAM")
+
+cleanup() {
+	echo "$orig" > "$PARAM"
+	echo "rem_device_all" > /proc/net/pktgen/kpktgend_0 2>/dev/null
+	cleanup_all_ns
+}
+trap cleanup EXIT
+
+setup_ns ns1 ns2
+ip link add veth0 netns "$ns1" type veth peer name veth0 netns "$ns2"
+ip -net "$ns1" addr add 10.0.1.1/24 dev veth0
+ip -net "$ns2" addr add 10.0.1.2/24 dev veth0
+ip -net "$ns1" link set veth0 up
+ip -net "$ns2" link set veth0 up
+dmac=$(ip -net "$ns2" -br link show veth0 | awk '{print $3}')
+
+pgset() {
+	echo "$2" > "/proc/net/pktgen/$1"
+}
+
+load_rules() {
+	local n=$1
+	local i
+
+	{
+		echo "*raw"
+		echo ":PREROUTING ACCEPT [0:0]"
+		for ((i = 0; i < n; i++)); do
+			echo "-A PREROUTING -s 198.18.$((i / 250)).$((i % 250 + 1))/32 -p udp -j DROP"
+		done
+		echo "-A PREROUTING -s 10.0.1.1/32 -p udp -j DROP"
+		echo "COMMIT"
+	} | ip netns exec "$ns2" iptables-restore
+}
+
+run_pktgen() {
+	ip netns exec "$ns1" bash -c "
+		echo rem_device_all > /proc/net/pktgen/kpktgend_0
+		echo add_device veth0 > /proc/net/pktgen/kpktgend_0
+		echo 'count 0' > /proc/net/pktgen/veth0
+		echo 'pkt_size 64' > /proc/net/pktgen/veth0
+		echo 'dst 10.0.1.2' > /proc/net/pktgen/veth0
+		echo 'src_min 10.0.1.1' > /proc/net/pktgen/veth0
+		echo 'src_max 10.0.1.1' > /proc/net/pktgen/veth0
+		echo 'dst_mac $dmac' > /proc/net/pktgen/veth0
+		echo 'udp_dst_min 9' > /proc/net/pktgen/veth0
+		echo 'udp_dst_max 9' > /proc/net/pktgen/veth0
+		timeout $DURATION sh -c 'echo start > /proc/net/pktgen/pgctrl'
+	" 2>/dev/null
+}
+
+measure() {
+	local n=$1
+	local pkts
+
+	load_rules "$n"
+	run_pktgen
+	pkts=$(ip netns exec "$ns2" iptables -t raw -L PREROUTING -v -x -n |
+		awk '/10\.0\.1\.1/ { print $1 }')
+	echo $((pkts / DURATION))
+}
+
+printf "%-8s %16s %16s\n" "rules" "linear pps" "indexed pps"
+for n in $RULES; do
+	echo 0 > "$PARAM"
+	linear=$(measure "$n")
+	echo 1 > "$PARAM"
+	indexed=$(measure "$n")
+	printf "%-8s %16s %16s\n" "$n" "$linear" "$indexed"
+done
+
+exit 0